@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "BVH.h"
+
+constexpr int BVH_BINS = 16;
+constexpr uint32_t BVH_MAX_LEAF_SIZE = 4;
+constexpr int BVH_MAX_DEPTH = 64;
+
+// SAH costs of a ray-box test and a ray-triangle test.
+constexpr float BVH_TRAVERSAL_COST = 1.0f;
+constexpr float BVH_INTERSECTION_COST = 2.0f;
+
+static auto empty_aabb() -> AABB
+{
+    return { glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+}
+
+static auto grow(AABB& aabb, const AABB& other) -> void
+{
+    aabb.min = glm::min(aabb.min, other.min);
+    aabb.max = glm::max(aabb.max, other.max);
+}
+
+static auto surface_area(const AABB& aabb) -> float
+{
+    glm::vec3 size = aabb.size();
+    if (size.x < 0.0f) {
+        return 0.0f;
+    }
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+BVH::BVH(const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices)
+{
+    uint32_t num_triangles = indices.size() / 3;
+    if (num_triangles == 0) {
+        return;
+    }
+
+    m_triangles.resize(num_triangles);
+    m_bounds.resize(num_triangles);
+    m_centroids.resize(num_triangles);
+    for (uint32_t t = 0; t < num_triangles; t++) {
+        const auto& a = vertices[indices[t * 3 + 0]].position;
+        const auto& b = vertices[indices[t * 3 + 1]].position;
+        const auto& c = vertices[indices[t * 3 + 2]].position;
+        m_triangles[t] = t;
+        m_bounds[t] = { glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c)) };
+        m_centroids[t] = m_bounds[t].center();
+    }
+
+    m_nodes.reserve(num_triangles * 2);
+    m_nodes.emplace_back();
+    build(0, 0, num_triangles, 0);
+
+    m_corners.reserve(num_triangles * 3);
+    for (uint32_t t : m_triangles) {
+        for (int i = 0; i < 3; i++) {
+            m_corners.push_back(vertices[indices[t * 3 + i]].position);
+        }
+    }
+
+    m_bounds = {};
+    m_centroids = {};
+}
+
+// build splits triangles [first, first + count) at the cheapest of the
+// binned SAH planes on the longest centroid axis, or makes a leaf when no
+// split beats testing every triangle. Depth is capped so traversal fits in
+// a fixed stack.
+auto BVH::build(uint32_t node, uint32_t first, uint32_t count, int depth) -> void
+{
+    AABB bounds = empty_aabb();
+    AABB centroid_bounds = empty_aabb();
+    for (uint32_t i = first; i < first + count; i++) {
+        grow(bounds, m_bounds[m_triangles[i]]);
+        const auto& centroid = m_centroids[m_triangles[i]];
+        grow(centroid_bounds, { centroid, centroid });
+    }
+    m_nodes[node].min = bounds.min;
+    m_nodes[node].max = bounds.max;
+
+    auto make_leaf = [&]() {
+        m_nodes[node].first = first;
+        m_nodes[node].count = count;
+    };
+
+    glm::vec3 extent = centroid_bounds.size();
+    int axis = 0;
+    if (extent.y > extent[axis]) {
+        axis = 1;
+    }
+    if (extent.z > extent[axis]) {
+        axis = 2;
+    }
+    if (count <= BVH_MAX_LEAF_SIZE || extent[axis] <= 0.0f || depth >= BVH_MAX_DEPTH - 1) {
+        make_leaf();
+        return;
+    }
+
+    struct Bin {
+        AABB bounds = empty_aabb();
+        uint32_t count = 0;
+    };
+    std::array<Bin, BVH_BINS> bins = {};
+    float bin_scale = BVH_BINS / extent[axis];
+    auto bin_of = [&](uint32_t triangle) {
+        int bin = (int)((m_centroids[triangle][axis] - centroid_bounds.min[axis]) * bin_scale);
+        return std::min(bin, BVH_BINS - 1);
+    };
+    for (uint32_t i = first; i < first + count; i++) {
+        auto& bin = bins[bin_of(m_triangles[i])];
+        grow(bin.bounds, m_bounds[m_triangles[i]]);
+        bin.count++;
+    }
+
+    // Sweep from the right to get the cost of every right side, then from
+    // the left to find the cheapest split.
+    std::array<float, BVH_BINS - 1> right_cost = {};
+    AABB right = empty_aabb();
+    uint32_t right_count = 0;
+    for (int i = BVH_BINS - 1; i > 0; i--) {
+        grow(right, bins[i].bounds);
+        right_count += bins[i].count;
+        right_cost[i - 1] = surface_area(right) * right_count;
+    }
+
+    float best_cost = std::numeric_limits<float>::max();
+    int best_split = -1;
+    AABB left = empty_aabb();
+    uint32_t left_count = 0;
+    for (int i = 0; i < BVH_BINS - 1; i++) {
+        grow(left, bins[i].bounds);
+        left_count += bins[i].count;
+        float cost = surface_area(left) * left_count + right_cost[i];
+        if (left_count > 0 && left_count < count && cost < best_cost) {
+            best_cost = cost;
+            best_split = i;
+        }
+    }
+
+    float leaf_cost = BVH_INTERSECTION_COST * count;
+    float split_cost = BVH_TRAVERSAL_COST + BVH_INTERSECTION_COST * best_cost / surface_area(bounds);
+    if (best_split < 0 || split_cost >= leaf_cost) {
+        make_leaf();
+        return;
+    }
+
+    auto middle = std::partition(m_triangles.begin() + first, m_triangles.begin() + first + count,
+        [&](uint32_t triangle) { return bin_of(triangle) <= best_split; });
+    uint32_t left_size = middle - (m_triangles.begin() + first);
+
+    uint32_t left_node = m_nodes.size();
+    m_nodes.emplace_back();
+    build(left_node, first, left_size, depth + 1);
+
+    uint32_t right_node = m_nodes.size();
+    m_nodes.emplace_back();
+    build(right_node, first + left_size, count - left_size, depth + 1);
+
+    m_nodes[node].first = right_node;
+    m_nodes[node].count = 0;
+}
+
+// slab_distance returns the distance to where the ray enters the node, or
+// infinity if it misses or the node is farther than `max_distance`.
+static auto slab_distance(const BVHNode& node, const glm::vec3& origin, const glm::vec3& inverse_direction, float max_distance) -> float
+{
+    float entry = 0.0f;
+    float exit = max_distance;
+    for (int axis = 0; axis < 3; axis++) {
+        float t0 = (node.min[axis] - origin[axis]) * inverse_direction[axis];
+        float t1 = (node.max[axis] - origin[axis]) * inverse_direction[axis];
+        entry = std::max(entry, std::min(t0, t1));
+        exit = std::min(exit, std::max(t0, t1));
+    }
+    return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+}
+
+// Möller-Trumbore, two sided so picking works from under the map too.
+static auto triangle_distance(const Ray& ray, const glm::vec3* corners) -> float
+{
+    constexpr float EPSILON = 1e-7f;
+    glm::vec3 edge1 = corners[1] - corners[0];
+    glm::vec3 edge2 = corners[2] - corners[0];
+    glm::vec3 p = glm::cross(ray.direction, edge2);
+    float determinant = glm::dot(edge1, p);
+    if (std::abs(determinant) < EPSILON) {
+        return std::numeric_limits<float>::infinity();
+    }
+    float inverse_determinant = 1.0f / determinant;
+    glm::vec3 s = ray.origin - corners[0];
+    float u = glm::dot(s, p) * inverse_determinant;
+    if (u < 0.0f || u > 1.0f) {
+        return std::numeric_limits<float>::infinity();
+    }
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(ray.direction, q) * inverse_determinant;
+    if (v < 0.0f || u + v > 1.0f) {
+        return std::numeric_limits<float>::infinity();
+    }
+    float t = glm::dot(edge2, q) * inverse_determinant;
+    return t >= 0.0f ? t : std::numeric_limits<float>::infinity();
+}
+
+auto BVH::intersect(const Ray& ray) const -> std::optional<RayHit>
+{
+    if (m_nodes.empty()) {
+        return std::nullopt;
+    }
+
+    // Division by a zero component gives infinity, which the slab test
+    // handles as a ray parallel to that axis.
+    glm::vec3 inverse_direction = { 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z };
+
+    float nearest = std::numeric_limits<float>::infinity();
+    uint32_t nearest_slot = 0;
+
+    std::array<uint32_t, BVH_MAX_DEPTH> stack;
+    int stack_size = 0;
+    uint32_t node_index = 0;
+    if (slab_distance(m_nodes[0], ray.origin, inverse_direction, nearest) == std::numeric_limits<float>::infinity()) {
+        return std::nullopt;
+    }
+
+    while (true) {
+        const auto& node = m_nodes[node_index];
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                float t = triangle_distance(ray, &m_corners[i * 3]);
+                if (t < nearest) {
+                    nearest = t;
+                    nearest_slot = i;
+                }
+            }
+        } else {
+            // Visit the nearer child first and push the other.
+            uint32_t a = node_index + 1;
+            uint32_t b = node.first;
+            float ta = slab_distance(m_nodes[a], ray.origin, inverse_direction, nearest);
+            float tb = slab_distance(m_nodes[b], ray.origin, inverse_direction, nearest);
+            if (tb < ta) {
+                std::swap(a, b);
+                std::swap(ta, tb);
+            }
+            if (ta != std::numeric_limits<float>::infinity()) {
+                if (tb != std::numeric_limits<float>::infinity()) {
+                    assert(stack_size < BVH_MAX_DEPTH);
+                    stack[stack_size++] = b;
+                }
+                node_index = a;
+                continue;
+            }
+        }
+
+        // Pop until a node is still closer than the nearest hit.
+        bool found = false;
+        while (stack_size > 0 && !found) {
+            node_index = stack[--stack_size];
+            found = slab_distance(m_nodes[node_index], ray.origin, inverse_direction, nearest) != std::numeric_limits<float>::infinity();
+        }
+        if (!found) {
+            break;
+        }
+    }
+
+    if (nearest == std::numeric_limits<float>::infinity()) {
+        return std::nullopt;
+    }
+
+    RayHit hit = {};
+    hit.triangle = m_triangles[nearest_slot];
+    hit.distance = nearest;
+    hit.position = ray.origin + ray.direction * nearest;
+    return hit;
+}
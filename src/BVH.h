@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Geometry.h"
+
+#include "glm/glm.hpp"
+
+struct RayHit {
+    uint32_t triangle = 0; // Index into the mesh's triangle list
+    float distance = 0.0f; // Along the ray, in units of its direction
+    glm::vec3 position = {};
+};
+
+// BVHNode is 32 bytes so two fit in a cache line. Interior nodes have a
+// count of 0; their left child follows them and `first` is the right
+// child. Leaves hold `count` triangles starting at `first`.
+struct BVHNode {
+    glm::vec3 min = {};
+    uint32_t first = 0;
+    glm::vec3 max = {};
+    uint32_t count = 0;
+};
+static_assert(sizeof(BVHNode) == 32);
+
+// BVH is a bounding volume hierarchy over an indexed triangle list, built
+// with binned SAH, for ray picking.
+class BVH {
+public:
+    BVH(const std::vector<Vertex>& vertices, const std::vector<uint16_t>& indices);
+
+    // intersect returns the nearest triangle hit by the ray, if any.
+    auto intersect(const Ray& ray) const -> std::optional<RayHit>;
+
+    auto node_count() const -> size_t { return m_nodes.size(); }
+    auto triangle_count() const -> size_t { return m_triangles.size(); }
+
+    // num_bytes is the memory held by the nodes and the triangles' corners.
+    auto num_bytes() const -> size_t
+    {
+        return sizeof(BVH) + m_nodes.size() * sizeof(BVHNode) + m_triangles.size() * sizeof(uint32_t) + m_corners.size() * sizeof(glm::vec3);
+    }
+
+private:
+    auto build(uint32_t node, uint32_t first, uint32_t count, int depth) -> void;
+
+    std::vector<BVHNode> m_nodes = {};
+
+    // Triangle ids in leaf order, and their corners gathered in the same
+    // order so leaf tests read memory linearly.
+    std::vector<uint32_t> m_triangles = {};
+    std::vector<glm::vec3> m_corners = {};
+
+    // Build scratch: per triangle bounds and centroids, indexed by id.
+    std::vector<AABB> m_bounds = {};
+    std::vector<glm::vec3> m_centroids = {};
+};
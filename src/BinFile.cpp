@@ -1,11 +1,31 @@
+#include <array>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <tuple>
+
 #include "BinFile.h"
-#include "ResourceManager.h"
+#include "SIMD.h"
+
+auto BinFile::check(size_t num) const -> void
+{
+#ifdef HERETIC_BOUNDS_CHECKS
+    if (m_offset > m_data.size() || num > m_data.size() - m_offset) {
+        fprintf(stderr, "Read of %zu bytes at offset %llu is past the end of a %zu byte file\n", num, (unsigned long long)m_offset, m_data.size());
+        exit(1);
+    }
+#else
+    (void)num;
+#endif
+}
 
 template <typename T>
 auto BinFile::read() -> T
 {
+    check(sizeof(T));
     T value;
-    memcpy(&value, &m_data[m_offset], sizeof(T));
+    memcpy(&value, m_data.data() + m_offset, sizeof(T));
     m_offset += sizeof(T);
     return value;
 }
@@ -17,10 +37,10 @@ auto BinFile::read_i8() -> int8_t { return read<int8_t>(); }
 auto BinFile::read_i16() -> int16_t { return read<int16_t>(); }
 auto BinFile::read_i32() -> int32_t { return read<int32_t>(); }
 
-auto BinFile::read_bytes(int num) -> std::vector<uint8_t>
+auto BinFile::read_bytes(size_t num) -> std::span<const uint8_t>
 {
-    std::vector<uint8_t> bytes(num);
-    std::memcpy(bytes.data(), m_data.data() + m_offset, num);
+    check(num);
+    auto bytes = m_data.subspan(m_offset, num);
     m_offset += num;
     return bytes;
 }
@@ -33,8 +53,8 @@ auto GNSFile::read_records() -> std::vector<Record>
 {
     std::vector<Record> records;
     while (true) {
-        Record record { read_bytes(20) };
-        if (record.resource_type() == ResourceType::End) {
+        Record record { read_bytes(GNS_RECORD_SIZE) };
+        if (record.resource_type == ResourceType::End) {
             break;
         }
         records.push_back(record);
@@ -46,26 +66,14 @@ auto GNSFile::read_records() -> std::vector<Record>
 // TextureFile
 //
 
-auto TextureFile::read_texture() -> std::shared_ptr<Texture>
+auto TextureFile::read_texture() -> std::vector<uint8_t>
 {
-    std::array<uint8_t, FFT_TEXTURE_NUM_BYTES> pixels = {};
-
-    for (int i = 0, j = 0; i < FFT_TEXTURE_RAW_SIZE; i++, j += 8) {
-        uint8_t raw_pixel = m_data.at(i);
-        uint8_t right = ((raw_pixel & 0x0F));
-        uint8_t left = ((raw_pixel & 0xF0) >> 4);
-        pixels.at(j + 0) = right;
-        pixels.at(j + 1) = right;
-        pixels.at(j + 2) = right;
-        pixels.at(j + 3) = right;
-        pixels.at(j + 4) = left;
-        pixels.at(j + 5) = left;
-        pixels.at(j + 6) = left;
-        pixels.at(j + 7) = left;
-    }
+    static_assert(FFT_TEXTURE_NUM_BYTES == FFT_TEXTURE_RAW_SIZE * 2);
 
-    auto texture = std::make_shared<Texture>(pixels);
-    return texture;
+    std::vector<uint8_t> pixels(FFT_TEXTURE_NUM_BYTES);
+    auto raw = read_bytes(FFT_TEXTURE_RAW_SIZE);
+    unpack_4bpp(raw.data(), raw.size(), pixels.data());
+    return pixels;
 }
 
 //
@@ -75,18 +83,27 @@ auto TextureFile::read_texture() -> std::shared_ptr<Texture>
 auto MeshFile::read_mesh() -> std::shared_ptr<FFTMesh>
 {
     auto mesh = std::make_shared<FFTMesh>();
-    mesh->vertices = read_vertices();
+    std::tie(mesh->vertices, mesh->indices, mesh->polygons) = read_vertices();
     mesh->palette = read_palette();
 
     auto [lights, ambient_color, background] = read_lights();
     mesh->lights = lights;
     mesh->ambient_color = ambient_color;
     mesh->background = background;
+    mesh->terrain = read_terrain();
 
     return mesh;
 }
 
-auto MeshFile::read_vertices() -> std::vector<Vertex>
+// Corner order of the output vertices of each polygon. Polygons are CW on
+// disc, so b and c swap to make them CCW. Quads are split into two triangles.
+constexpr std::array<uint16_t, 3> TRIANGLE_CORNERS = { 0, 2, 1 };
+constexpr std::array<uint16_t, 6> QUAD_CORNERS = { 0, 2, 1, 1, 2, 3 };
+
+// Byte offset of each corner's UV within a textured polygon's UV data.
+constexpr std::array<int, 4> UV_CORNER_OFFSETS = { 0, 4, 8, 10 };
+
+auto MeshFile::read_vertices() -> std::tuple<std::vector<Vertex>, std::vector<uint16_t>, std::vector<uint16_t>>
 {
     // 0x40 is always the location of the primary mesh pointer.
     // 0xC4 is always the primary mesh pointer.
@@ -107,113 +124,47 @@ auto MeshFile::read_vertices() -> std::vector<Vertex>
     // Validate maximum values
     assert(N < 512 && P < 768 && Q < 64 && R < 256);
 
-    std::vector<Vertex> vertices;
-    vertices.resize((N * 3) + (P * 3 * 2) + (Q * 3) + (R * 3 * 2));
-
-    int index = 0;
-
-    // Textured triangle vertices
-    for (int i = index; i < N * 3; i = i + 3) {
-        auto a = read_position();
-        auto b = read_position();
-        auto c = read_position();
-
-        vertices.at(i + 0).position = a;
-        vertices.at(i + 1).position = c; // b/c swap for CW->CCW
-        vertices.at(i + 2).position = b;
-    }
-
-    index = index + (N * 3);
-
-    // Textured quad vertices. Split into 2 triangles.
-    for (int i = index; i < index + (P * 2 * 3); i = i + 6) {
-        glm::vec3 a = read_position();
-        glm::vec3 b = read_position();
-        glm::vec3 c = read_position();
-        glm::vec3 d = read_position();
-
-        // Triangle A
-        vertices.at(i + 0).position = a;
-        vertices.at(i + 1).position = c; // b/c swap for CW->CCW
-        vertices.at(i + 2).position = b;
-
-        // Triangle B
-        vertices.at(i + 3).position = b;
-        vertices.at(i + 4).position = c; // c/d swap for CW-CCW
-        vertices.at(i + 5).position = d;
-    }
-
-    index = index + (P * 2 * 3);
-
-    // Untextured triangle vertices
-    for (int i = index; i < index + (Q * 3); i = i + 3) {
-        auto a = read_position();
-        auto b = read_position();
-        auto c = read_position();
+    // Each block lists its polygons' corners in the same order: N, P, Q then
+    // R polygons, but only textured polygons have normals and UVs.
+    int num_corners = (N * 3) + (P * 4) + (Q * 3) + (R * 4);
+    int num_textured_corners = (N * 3) + (P * 4);
 
-        vertices.at(i + 0).position = a;
-        vertices.at(i + 1).position = c; // b/c swap for CW->CCW
-        vertices.at(i + 2).position = b;
-    }
-
-    index = index + (Q * 3);
-
-    // Untextured quad vertices. Split into 2 triangles.
-    for (int i = index; i < index + (R * 2 * 3); i = i + 6) {
-        glm::vec3 a = read_position();
-        glm::vec3 b = read_position();
-        glm::vec3 c = read_position();
-        glm::vec3 d = read_position();
-
-        // Triangle A
-        vertices.at(i + 0).position = a;
-        vertices.at(i + 1).position = c; // b/c swap for CW->CCW
-        vertices.at(i + 2).position = b;
-
-        // Triangle B
-        vertices.at(i + 3).position = b;
-        vertices.at(i + 4).position = c; // c/d swap for CW-CCW
-        vertices.at(i + 5).position = d;
-    }
-
-    index = index + (R * 2 * 3);
-
-    // Reset index so we can start over for normals, using the same vertices.
-    index = 0;
-
-    // Triangle normals
-    for (int i = index; i < N * 3; i = i + 3) {
-        auto a = read_normal();
-        auto b = read_normal();
-        auto c = read_normal();
-
-        vertices.at(i + 0).normal = a;
-        vertices.at(i + 1).normal = c; // b/c swap for CW->CCW
-        vertices.at(i + 2).normal = b;
-    }
-
-    index = index + (N * 3);
-
-    // Quad normals. Split into 2 triangles.
-    for (int i = index; i < index + (P * 2 * 3); i = i + 6) {
-        glm::vec3 a = read_normal();
-        glm::vec3 b = read_normal();
-        glm::vec3 c = read_normal();
-        glm::vec3 d = read_normal();
-
-        // Triangle A
-        vertices.at(i + 0).normal = a;
-        vertices.at(i + 1).normal = c; // b/c swap for CW->CCW
-        vertices.at(i + 2).normal = b;
-
-        // Triangle B
-        vertices.at(i + 3).normal = b;
-        vertices.at(i + 4).normal = c; // c/d swap for CW-CCW
-        vertices.at(i + 5).normal = d;
-    }
-
-    // Reset index so we can start over for texture data, using the same vertices.
-    index = 0;
+    // corner_of maps each triangle list slot to the corner it comes from, so
+    // a quad's two triangles share their diagonal. The same table indexes the
+    // position, normal and UV streams. polygons records the polygon each
+    // triangle comes from, numbered in file order.
+    //
+    // The streams are scratch space kept per thread, so decoding mesh after
+    // mesh doesn't keep faulting in freshly allocated pages.
+    thread_local std::vector<uint16_t> corner_of;
+    corner_of.clear();
+    std::vector<uint16_t> polygons;
+    polygons.reserve((N + Q) + (P + R) * 2);
+    uint16_t base = 0;
+    uint16_t polygon = 0;
+    auto add_polygons = [&](int count, const auto& order, uint16_t corners_per_polygon) {
+        for (int i = 0; i < count; i++, base += corners_per_polygon, polygon++) {
+            for (auto corner : order) {
+                corner_of.push_back(base + corner);
+            }
+            polygons.insert(polygons.end(), order.size() / 3, polygon);
+        }
+    };
+    add_polygons(N, TRIANGLE_CORNERS, 3);
+    add_polygons(P, QUAD_CORNERS, 4);
+    add_polygons(Q, TRIANGLE_CORNERS, 3);
+    add_polygons(R, QUAD_CORNERS, 4);
+
+    // Positions are int16 triples. Normals are 1.3.12 fixed point triples.
+    auto position_bytes = read_bytes(num_corners * 6);
+    thread_local std::vector<float> positions;
+    positions.resize(num_corners * 3);
+    convert_i16(position_bytes.data(), positions.size(), 1.0f, positions.data());
+
+    auto normal_bytes = read_bytes(num_textured_corners * 6);
+    thread_local std::vector<float> normals;
+    normals.resize(num_textured_corners * 3);
+    convert_i16(normal_bytes.data(), normals.size(), 1.0f / 4096.0f, normals.data());
 
     // 16 palettes of 16 colors of 4 bytes
     // process_tex_coords has two functions:
@@ -230,83 +181,188 @@ auto MeshFile::read_vertices() -> std::vector<Vertex>
         return { u, v };
     };
 
-    // Triangle UV
-    for (int i = index; i < N * 3; i = i + 3) {
-        float au = read_u8();
-        float av = read_u8();
-        float palette = read_u8();
-        (void)read_u8(); // padding
-        float bu = read_u8();
-        float bv = read_u8();
-        float page = (read_u8() & 0x03); // 0b00000011
-        (void)read_u8();                 // padding
-        float cu = read_u8();
-        float cv = read_u8();
-
-        glm::vec2 a = process_tex_coords(au, av, page);
-        glm::vec2 b = process_tex_coords(bu, bv, page);
-        glm::vec2 c = process_tex_coords(cu, cv, page);
-
-        vertices.at(i + 0).tex_coords = a;
-        vertices.at(i + 0).palette_index = palette;
-        vertices.at(i + 1).tex_coords = c; // b/c swap for CW->CCW
-        vertices.at(i + 1).palette_index = palette;
-        vertices.at(i + 2).tex_coords = b;
-        vertices.at(i + 2).palette_index = palette;
+    // UVs are stored per polygon: a, palette, b, page, c and for quads d.
+    // They are expanded per corner to match the other streams.
+    thread_local std::vector<glm::vec2> tex_coords;
+    thread_local std::vector<float> palettes;
+    tex_coords.resize(num_textured_corners);
+    palettes.resize(num_textured_corners);
+    auto uv_bytes = read_bytes((N * 10) + (P * 12));
+    const uint8_t* uv = uv_bytes.data();
+    int corner = 0;
+    auto read_uvs = [&](int count, int corners_per_polygon) {
+        for (int i = 0; i < count; i++, uv += (corners_per_polygon * 2) + 4) {
+            float palette = uv[2];
+            uint8_t page = uv[6] & 0x03; // 0b00000011
+            for (int c = 0; c < corners_per_polygon; c++, corner++) {
+                const uint8_t* coords = uv + UV_CORNER_OFFSETS[c];
+                tex_coords[corner] = process_tex_coords(coords[0], coords[1], page);
+                palettes[corner] = palette;
+            }
+        }
+    };
+    read_uvs(N, 3);
+    read_uvs(P, 4);
+
+    // Build one vertex per corner, then share identical vertices between
+    // polygons. Untextured polygons have no normals or UVs, so their shared
+    // edges collapse entirely. Positions and normals are flipped on y and z.
+    //
+    // Vertices are compared bitwise through an open addressing table of
+    // vertex indices, at most half full.
+    constexpr uint16_t EMPTY = UINT16_MAX;
+    auto hash_of = [](const Vertex& vertex) {
+        uint32_t words[sizeof(Vertex) / sizeof(uint32_t)];
+        std::memcpy(words, &vertex, sizeof(Vertex));
+        uint32_t hash = 2166136261u;
+        for (uint32_t word : words) {
+            hash = (hash ^ word) * 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    };
+    thread_local std::vector<uint16_t> table;
+    table.assign(std::bit_ceil((size_t)num_corners * 2), EMPTY);
+    size_t table_mask = table.size() - 1;
+
+    std::vector<Vertex> vertices;
+    vertices.reserve(num_corners);
+    thread_local std::vector<uint16_t> vertex_of;
+    vertex_of.resize(num_corners);
+
+    for (int c = 0; c < num_corners; c++) {
+        Vertex vertex;
+        const float* p = &positions[c * 3];
+        vertex.position = { p[0], -p[1], -p[2] };
+        if (c < num_textured_corners) {
+            const float* n = &normals[c * 3];
+            vertex.normal = { n[0], -n[1], -n[2] };
+            vertex.tex_coords = tex_coords[c];
+            vertex.palette_index = palettes[c];
+            vertex.textured = 1;
+        }
+
+        size_t slot = hash_of(vertex) & table_mask;
+        while (table[slot] != EMPTY && std::memcmp(&vertices[table[slot]], &vertex, sizeof(Vertex)) != 0) {
+            slot = (slot + 1) & table_mask;
+        }
+        if (table[slot] == EMPTY) {
+            table[slot] = vertices.size();
+            vertices.push_back(vertex);
+        }
+        vertex_of[c] = table[slot];
+    }
+
+    std::vector<uint16_t> indices(corner_of.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = vertex_of[corner_of[i]];
     }
 
-    index = index + (N * 3);
-
-    // Quad UV. Split into 2 triangles.
-    for (int i = index; i < index + (P * 2 * 3); i = i + 6) {
-        float au = read_u8();
-        float av = read_u8();
-        float palette = read_u8();
-        (void)read_u8(); // padding
-        float bu = read_u8();
-        float bv = read_u8();
-        float page = (read_u8() & 0x03); // 0b00000011
-        (void)read_u8();                 // padding
-        float cu = read_u8();
-        float cv = read_u8();
-        float du = read_u8();
-        float dv = read_u8();
-
-        glm::vec2 a = process_tex_coords(au, av, page);
-        glm::vec2 b = process_tex_coords(bu, bv, page);
-        glm::vec2 c = process_tex_coords(cu, cv, page);
-        glm::vec2 d = process_tex_coords(du, dv, page);
-
-        // Triangle A
-        vertices.at(i + 0).tex_coords = a;
-        vertices.at(i + 0).palette_index = palette;
-        vertices.at(i + 1).tex_coords = c; // b/c swap for CW->CCW
-        vertices.at(i + 1).palette_index = palette;
-        vertices.at(i + 2).tex_coords = b;
-        vertices.at(i + 2).palette_index = palette;
-
-        // Triangle B
-        vertices.at(i + 3).tex_coords = b;
-        vertices.at(i + 3).palette_index = palette;
-        vertices.at(i + 4).tex_coords = c; // c/d swap for CW-CCW
-        vertices.at(i + 4).palette_index = palette;
-        vertices.at(i + 5).tex_coords = d;
-        vertices.at(i + 5).palette_index = palette;
+    return { vertices, indices, polygons };
+}
+
+auto MeshFile::read_vertices_reference() -> std::vector<Vertex>
+{
+    m_offset = 0x40;
+    uint32_t intra_file_ptr = read_u32();
+    if (intra_file_ptr == 0) {
+        return {};
+    }
+
+    m_offset = intra_file_ptr;
+
+    uint16_t N = read_u16(); // Textured triangles
+    uint16_t P = read_u16(); // Textured quads
+    uint16_t Q = read_u16(); // Untextured triangles
+    uint16_t R = read_u16(); // Untextured quads
+    assert(N < 512 && P < 768 && Q < 64 && R < 256);
+
+    std::vector<Vertex> vertices((N * 3) + (P * 6) + (Q * 3) + (R * 6));
+
+    // read_polygons reads `count` polygons' corners with `read` and stores
+    // them with `set` from vertex `first` on, swapping b and c for CW->CCW
+    // and splitting quads into two triangles. It returns the next vertex.
+    auto read_polygons = [&](size_t first, int count, bool is_quad, auto&& read, auto&& set) -> size_t {
+        for (int i = 0; i < count; i++) {
+            auto a = read();
+            auto b = read();
+            auto c = read();
+            set(vertices.at(first + 0), a);
+            set(vertices.at(first + 1), c);
+            set(vertices.at(first + 2), b);
+            if (is_quad) {
+                auto d = read();
+                set(vertices.at(first + 3), b);
+                set(vertices.at(first + 4), c);
+                set(vertices.at(first + 5), d);
+            }
+            first += is_quad ? 6 : 3;
+        }
+        return first;
+    };
+
+    auto read_flipped = [&](float scale) {
+        return [this, scale]() -> glm::vec3 {
+            float x = read_i16() * scale;
+            float y = read_i16() * scale;
+            float z = read_i16() * scale;
+            return { x, -y, -z };
+        };
+    };
+    auto set_position = [](Vertex& vertex, glm::vec3 position) { vertex.position = position; };
+    auto set_normal = [](Vertex& vertex, glm::vec3 normal) { vertex.normal = normal; };
+
+    size_t next = 0;
+    next = read_polygons(next, N, false, read_flipped(1.0f), set_position);
+    next = read_polygons(next, P, true, read_flipped(1.0f), set_position);
+    next = read_polygons(next, Q, false, read_flipped(1.0f), set_position);
+    read_polygons(next, R, true, read_flipped(1.0f), set_position);
+
+    // Only textured polygons have normals and UVs.
+    next = read_polygons(0, N, false, read_flipped(1.0f / 4096.0f), set_normal);
+    read_polygons(next, P, true, read_flipped(1.0f / 4096.0f), set_normal);
+
+    // UVs: a, palette, padding, b, page, padding, c and for quads d. The
+    // page moves v to one of the texture's four 256 pixel pages.
+    float palette = 0.0f;
+    uint8_t page = 0;
+    int corner = 0;
+    auto read_uv = [&]() -> glm::vec2 {
+        float u = read_u8();
+        float v = read_u8();
+        if (corner == 0) {
+            palette = read_u8();
+            (void)read_u8();
+        } else if (corner == 1) {
+            page = read_u8() & 0x03;
+            (void)read_u8();
+        }
+        corner++;
+        return { u, v };
+    };
+    auto set_uv = [&](Vertex& vertex, glm::vec2 uv) {
+        vertex.tex_coords = { uv.x / 255.0f, (uv.y + (page * 256)) / 1023.0f };
+        vertex.palette_index = palette;
+        vertex.textured = 1;
+    };
+    for (int i = 0; i < N + P; i++) {
+        bool is_quad = i >= N;
+        corner = 0;
+        read_polygons(i < N ? i * 3 : (N * 3) + ((i - N) * 6), 1, is_quad, read_uv, set_uv);
     }
 
     return vertices;
 }
 
-auto MeshFile::read_palette() -> std::shared_ptr<Texture>
+auto MeshFile::read_palette() -> std::vector<uint8_t>
 {
     m_offset = 0x44;
     uint32_t intra_file_ptr = read_u32();
     if (intra_file_ptr == 0) {
-        return nullptr;
+        return {};
     }
     m_offset = intra_file_ptr;
 
-    std::array<uint8_t, FFT_PALETTE_NUM_BYTES> pixels = {};
+    std::vector<uint8_t> pixels(FFT_PALETTE_NUM_BYTES);
 
     for (int i = 0; i < 16 * 16 * 4; i = i + 4) {
         glm::vec4 c = read_rgb15();
@@ -316,11 +372,22 @@ auto MeshFile::read_palette() -> std::shared_ptr<Texture>
         pixels.at(i + 3) = c.w;
     }
 
-    auto palette = std::make_shared<Texture>(pixels);
-    return palette;
+    return pixels;
 }
 
-auto MeshFile::read_lights() -> std::tuple<std::vector<std::shared_ptr<Light>>, glm::vec4, std::pair<glm::vec4, glm::vec4>>
+auto MeshFile::read_terrain() -> Terrain
+{
+    m_offset = 0x68;
+    uint32_t intra_file_ptr = read_u32();
+    if (intra_file_ptr == 0) {
+        return {};
+    }
+
+    m_offset = intra_file_ptr;
+    return Terrain(read_bytes(TERRAIN_NUM_BYTES));
+}
+
+auto MeshFile::read_lights() -> std::tuple<std::vector<LightData>, glm::vec4, std::pair<glm::vec4, glm::vec4>>
 {
     m_offset = 0x64;
     uint32_t intra_file_ptr = read_u32();
@@ -356,22 +423,11 @@ auto MeshFile::read_lights() -> std::tuple<std::vector<std::shared_ptr<Light>>,
     b_pos = read_position();
     c_pos = read_position();
 
-    auto resources = ResourceManager::get_instance();
-    auto cube_mesh = resources->get_mesh("cube");
-    auto a = std::make_shared<Light>(cube_mesh, a_color, a_pos);
-    auto b = std::make_shared<Light>(cube_mesh, b_color, b_pos);
-    auto c = std::make_shared<Light>(cube_mesh, c_color, c_pos);
-
-    std::vector<std::shared_ptr<Light>> directional_lights = {};
-
-    if (a->is_valid()) {
-        directional_lights.push_back(a);
-    }
-    if (b->is_valid()) {
-        directional_lights.push_back(b);
-    }
-    if (c->is_valid()) {
-        directional_lights.push_back(c);
+    std::vector<LightData> directional_lights = {};
+    for (auto light : { LightData { a_color, a_pos }, LightData { b_color, b_pos }, LightData { c_color, c_pos } }) {
+        if (light.is_valid()) {
+            directional_lights.push_back(light);
+        }
     }
 
     auto ambient_color = read_rgb8();
@@ -399,18 +455,6 @@ auto MeshFile::read_position() -> glm::vec3
     return { x, y, z };
 }
 
-auto MeshFile::read_normal() -> glm::vec3
-{
-    float x = read_f1x3x12();
-    float y = read_f1x3x12();
-    float z = read_f1x3x12();
-
-    y = -y;
-    z = -z;
-
-    return { x, y, z };
-}
-
 // read_light_color clamps the value between 0.0 and 1.0. These unclamped values
 // are used to affect the lighting model but it isn't understood yet.
 // https://ffhacktics.com/wiki/Maps/Mesh#Light_colors_and_positions.2C_background_gradient_colors
@@ -463,9 +507,7 @@ auto AttackOutFile::read_scenarios() -> std::vector<Scenario>
 
     std::vector<Scenario> scenarios;
     for (int i = 0; i < scenario_count; i++) {
-        auto bytes = read_bytes(scenario_size);
-        Scenario scenario { bytes };
-        scenarios.push_back(scenario);
+        scenarios.emplace_back(read_bytes(scenario_size));
     }
     return scenarios;
 }
@@ -478,9 +520,7 @@ auto EventFile::read_events() -> std::vector<Event>
 
     std::vector<Event> events;
     for (int i = 0; i < event_count; i++) {
-        auto bytes = read_bytes(event_size);
-        Event event { bytes };
-        events.push_back(event);
+        events.emplace_back(read_bytes(event_size));
     }
     return events;
 }
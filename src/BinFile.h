@@ -2,20 +2,32 @@
 
 #include <cstdint>
 #include <memory>
+#include <span>
 #include <vector>
 
 #include "Event.h"
+#include "FFT.h"
 #include "Scenario.h"
-#include "Texture.h"
 
 // DEGREE_PER_UNIT is used to convert the angles in the BIN files to degrees.
 // ie, the angle and rotation values of a Camera Instruction.
 constexpr float DEGREE_PER_UNIT = 45.0f / 512.0f; // 0.087890625
 
 // BinFile represents an individual file in the FFT BIN.
+//
+// BinFile is a cursor over a span of bytes. It either owns its bytes or
+// borrows them from memory that outlives it, such as the mapped disc image.
+// Copies share the same bytes. read_bytes() hands out sub-spans, so parsing
+// doesn't allocate per field.
+//
+// Reads are bounds checked when HERETIC_BOUNDS_CHECKS is defined, which is
+// the default for Debug builds.
 class BinFile {
 public:
-    BinFile(std::vector<uint8_t> data)
+    explicit BinFile(std::vector<uint8_t> data)
+        : m_storage(std::make_shared<const std::vector<uint8_t>>(std::move(data)))
+        , m_data(*m_storage) {};
+    explicit BinFile(std::span<const uint8_t> data)
         : m_data(data) {};
 
     auto read_u8() -> uint8_t;
@@ -25,10 +37,18 @@ public:
     auto read_i16() -> int16_t;
     auto read_i32() -> int32_t;
 
-    auto read_bytes(int num) -> std::vector<uint8_t>;
+    // read_bytes returns a view into the file. It is valid as long as the
+    // file, or any copy of it, is alive.
+    auto read_bytes(size_t num) -> std::span<const uint8_t>;
+
+    auto seek(uint64_t offset) -> void { m_offset = offset; }
+    auto size() const -> size_t { return m_data.size(); }
 
 protected:
-    std::vector<uint8_t> m_data;
+    auto check(size_t num) const -> void;
+
+    std::shared_ptr<const std::vector<uint8_t>> m_storage = nullptr;
+    std::span<const uint8_t> m_data;
     uint64_t m_offset = 0;
 
 private:
@@ -43,21 +63,30 @@ public:
 
 class TextureFile : public BinFile {
 public:
-    auto read_texture() -> std::shared_ptr<Texture>;
+    // read_texture returns the texture as one palette index per pixel (R8).
+    auto read_texture() -> std::vector<uint8_t>;
 };
 
 class MeshFile : public BinFile {
 public:
     auto read_mesh() -> std::shared_ptr<FFTMesh>;
 
+    // read_vertices decodes the primary mesh as an indexed triangle list,
+    // with the source polygon of each triangle.
+    auto read_vertices() -> std::tuple<std::vector<Vertex>, std::vector<uint16_t>, std::vector<uint16_t>>;
+
+    // read_vertices_reference is the original decoder: one value at a time
+    // and one vertex per triangle corner. Vertex i must equal
+    // vertices[indices[i]] of read_vertices bit for bit. See --bench-meshes.
+    auto read_vertices_reference() -> std::vector<Vertex>;
+
 private:
-    auto read_vertices() -> std::vector<Vertex>;
-    auto read_palette() -> std::shared_ptr<Texture>;
-    auto read_lights() -> std::tuple<std::vector<std::shared_ptr<Light>>, glm::vec4, std::pair<glm::vec4, glm::vec4>>;
+    auto read_palette() -> std::vector<uint8_t>;
+    auto read_lights() -> std::tuple<std::vector<LightData>, glm::vec4, std::pair<glm::vec4, glm::vec4>>;
     auto read_background() -> std::pair<glm::vec4, glm::vec4>;
+    auto read_terrain() -> Terrain;
 
     auto read_position() -> glm::vec3;
-    auto read_normal() -> glm::vec3;
     auto read_light_color() -> float;
     auto read_f1x3x12() -> float;
     auto read_rgb8() -> glm::vec4;
@@ -1,98 +1,244 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
 #include <utility>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HERETIC_IO_URING
+#include <liburing.h>
+#endif
+
 #include "BinReader.h"
 #include "Event.h"
-#include "ResourceManager.h"
 #include "Scenario.h"
+#include "VertexCache.h"
 
-BinReader::BinReader(std::string filename)
-{
+// Positional mode reads at most this many raw sectors per pread() call. This
+// bounds the scratch buffer while still turning the 2000 sector event file
+// into a few dozen syscalls.
+constexpr uint32_t POSITIONAL_CHUNK_SECTORS = 64;
 
-    file = fopen(filename.c_str(), "r");
-    if (!file) {
+BinReader::BinReader(std::string filename, ReadMode mode)
+    : m_mode(mode)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
         fprintf(stderr, "Failed to open file: %s\n", filename.c_str());
         exit(1);
     }
+
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)SECTOR_SIZE_RAW) {
+        fprintf(stderr, "Failed to stat file: %s\n", filename.c_str());
+        exit(1);
+    }
+    m_image_size = st.st_size;
+
+    m_fd = fd;
+
+    if (m_mode == ReadMode::Mapped) {
+        void* image = mmap(nullptr, m_image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (image != MAP_FAILED) {
+            m_image = static_cast<const uint8_t*>(image);
+
+            // Loading a map jumps between the GNS file, textures and meshes
+            // that are spread all over the disc, so the kernel's default
+            // readahead mostly pulls in sectors we never touch. Individual
+            // files are prefetched in read_file.
+            madvise(image, m_image_size, MADV_RANDOM);
+        } else {
+            fprintf(stderr, "Failed to map file, falling back to positional reads: %s\n", filename.c_str());
+            m_mode = ReadMode::Positional;
+        }
+    }
+
+    // Walking the directory tree touches a few dozen sectors scattered over
+    // the start of the disc, so the result is cached next to the image.
+    auto index_filename = filename + ".index";
+    if (!m_index.load(index_filename, st.st_size, st.st_mtime)) {
+        m_index = build_index();
+        if (m_index.size() == 0) {
+            fprintf(stderr, "No files found on disc: %s\n", filename.c_str());
+            exit(1);
+        }
+        if (!m_index.save(index_filename, st.st_size, st.st_mtime)) {
+            fprintf(stderr, "Failed to write disc index: %s\n", index_filename.c_str());
+        }
+    }
+
+    // FNV-1a
+    auto pvd_file = read_file(ISO_PRIMARY_VOLUME_DESCRIPTOR_SECTOR, SECTOR_SIZE);
+    auto pvd = pvd_file.read_bytes(SECTOR_SIZE);
+    uint64_t hash = 0xcbf29ce484222325;
+    for (uint8_t byte : pvd) {
+        hash = (hash ^ byte) * 0x100000001b3;
+    }
+    char fingerprint[17];
+    snprintf(fingerprint, sizeof(fingerprint), "%016llx", (unsigned long long)hash);
+    m_fingerprint = fingerprint;
 }
 
 BinReader::~BinReader()
 {
-    fclose(file);
+    if (m_image != nullptr) {
+        munmap(const_cast<uint8_t*>(m_image), m_image_size);
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
 }
 
-auto BinReader::read_map(int map_num, MapTime time, MapWeather weather, int arrangement) -> std::shared_ptr<FFTMap>
+// optimize_mesh reorders a mesh's triangles for the post-transform cache,
+// then lays vertices out in the order they are fetched. Disc order has
+// little vertex reuse between neighbouring triangles.
+static auto optimize_mesh(FFTMesh& mesh) -> void
 {
-    std::shared_ptr<FFTMesh> final_mesh = nullptr;
-    std::shared_ptr<FFTMesh> primary_mesh = nullptr;
-    std::shared_ptr<FFTMesh> alt_mesh = nullptr;
-    std::shared_ptr<FFTMesh> override_mesh = nullptr;
-    std::shared_ptr<Texture> texture = nullptr;
-    std::shared_ptr<Texture> fallback_texture = nullptr;
+    mesh.acmr_before = acmr(mesh.indices, mesh.vertices.size());
+    std::vector<uint32_t> triangle_order;
+    optimize_vertex_cache(mesh.indices, mesh.vertices.size(), &triangle_order);
+    std::vector<uint16_t> polygons(triangle_order.size());
+    for (size_t i = 0; i < triangle_order.size(); i++) {
+        polygons[i] = mesh.polygons[triangle_order[i]];
+    }
+    mesh.polygons = std::move(polygons);
+    optimize_vertex_fetch(mesh.vertices, mesh.indices);
+    mesh.acmr_after = acmr(mesh.indices, mesh.vertices.size());
+}
 
-    auto gns_records = read_gns_file(map_list[map_num].sector).read_records();
+auto BinReader::read_map_base(int map_num) const -> std::shared_ptr<const MapBase>
+{
+    {
+        std::lock_guard<std::mutex> lock(m_bases_mutex);
+        for (auto it = m_bases.begin(); it != m_bases.end(); it++) {
+            if (it->first == map_num) {
+                m_bases.splice(m_bases.begin(), m_bases, it);
+                return it->second;
+            }
+        }
+    }
 
-    for (auto& record : gns_records) {
-        bool is_match = record.time() == time && record.weather() == weather && record.arrangement() == arrangement;
-        bool is_default = record.time() == MapTime::Day && record.weather() == MapWeather::None && record.arrangement() == 0;
+    // Two threads may decode the same base at once. Both results are equal,
+    // so whichever is stored last wins.
+    auto base = std::make_shared<MapBase>();
+    base->gns_records = read_gns_file(map_list[map_num].sector).read_records();
 
+    std::shared_ptr<FFTMesh> primary_mesh = nullptr;
+    std::shared_ptr<FFTMesh> override_mesh = nullptr;
+    for (auto& record : base->gns_records) {
         // MeshPrimary and MeshOverride are special cases that use are always set to TimeDay, WeatherNone, Arrangement 0.
-        switch (record.resource_type()) {
-
+        switch (record.resource_type) {
         case ResourceType::MeshPrimary:
-            primary_mesh = read_mesh_file(record.sector(), record.length()).read_mesh();
+            primary_mesh = read_mesh_file(record.sector, record.length).read_mesh();
             break;
-
         case ResourceType::MeshOverride:
-            override_mesh = read_mesh_file(record.sector(), record.length()).read_mesh();
+            override_mesh = read_mesh_file(record.sector, record.length).read_mesh();
             break;
+        case ResourceType::Texture:
+        case ResourceType::MeshAlt:
+            break;
+        default:
+            std::cout << "Unknown resource type: " << std::endl;
+        }
+    }
 
+    // A few maps have no primary mesh, so we need to create one.
+    // 2, 8 ,15 ,16 ,18 ,33 ,34 ,41 ,55 ,68 ,92 ,94 ,95 ,96, 104
+    auto mesh = primary_mesh != nullptr ? primary_mesh : std::make_shared<FFTMesh>();
+    if (override_mesh != nullptr) {
+        merge_meshes(mesh, override_mesh);
+    }
+    optimize_mesh(*mesh);
+    mesh->base_num_vertices = mesh->vertices.size();
+    mesh->base_num_indices = mesh->indices.size();
+    mesh->base_data = make_map_mesh_data(*mesh, 0, mesh->vertices.size(), 0, mesh->indices.size());
+    base->mesh = mesh;
+
+    std::lock_guard<std::mutex> lock(m_bases_mutex);
+    m_bases.remove_if([&](const auto& entry) { return entry.first == map_num; });
+    m_bases.emplace_front(map_num, base);
+    if (m_bases.size() > MAP_BASE_CACHE_CAPACITY) {
+        m_bases.pop_back();
+    }
+    return base;
+}
+
+// read_map copies the map's base and appends the style's alt mesh. The alt
+// mesh is optimized on its own, so the base stays an unchanged prefix of the
+// final vertices and indices and the renderer can share it between styles.
+// Both parts are laid out for upload here, the base once per MapBase.
+auto BinReader::read_map(int map_num, MapTime time, MapWeather weather, int arrangement) const -> std::shared_ptr<FFTMap>
+{
+    auto base = read_map_base(map_num);
+
+    std::shared_ptr<FFTMesh> alt_mesh = nullptr;
+    std::vector<uint8_t> texture = {};
+    std::vector<uint8_t> fallback_texture = {};
+
+    for (auto& record : base->gns_records) {
+        bool is_match = record.style_key == style_key(time, weather, arrangement);
+        bool is_default = record.style_key == style_key(MapTime::Day, MapWeather::None, 0);
+
+        switch (record.resource_type) {
         case ResourceType::Texture:
             // Maps 51 and 105 have duplicate textures for the same conditions
             // but they are the same image data. Some maps don't have a texture
             // for the conditions so we need to fallback to the default.
             if (is_match) {
-                texture = read_texture_file(record.sector()).read_texture();
-            } else if (is_default) {
-                fallback_texture = read_texture_file(record.sector()).read_texture();
+                texture = read_texture_file(record.sector).read_texture();
+            } else if (is_default && texture.empty()) {
+                fallback_texture = read_texture_file(record.sector).read_texture();
             }
             break;
 
         case ResourceType::MeshAlt:
             if (is_match) {
-                alt_mesh = read_mesh_file(record.sector(), record.length()).read_mesh();
+                alt_mesh = read_mesh_file(record.sector, record.length).read_mesh();
             }
             break;
 
         default:
-            std::cout << "Unknown resource type: " << std::endl;
+            break;
         }
     }
 
-    // A few maps have no primary mesh, so we need to create one.
-    // 2, 8 ,15 ,16 ,18 ,33 ,34 ,41 ,55 ,68 ,92 ,94 ,95 ,96, 104
-    final_mesh = primary_mesh != nullptr ? primary_mesh : std::make_shared<FFTMesh>();
-
-    if (override_mesh != nullptr) {
-        merge_meshes(final_mesh, override_mesh);
-    }
-
+    auto final_mesh = std::make_shared<FFTMesh>(*base->mesh);
     if (alt_mesh != nullptr) {
+        optimize_mesh(*alt_mesh);
         merge_meshes(final_mesh, alt_mesh);
+
+        // ACMR is misses per triangle, so the parts combine by triangle count.
+        float base_triangles = base->mesh->indices.size() / 3.0f;
+        float alt_triangles = alt_mesh->indices.size() / 3.0f;
+        if (base_triangles + alt_triangles > 0.0f) {
+            final_mesh->acmr_before = (base->mesh->acmr_before * base_triangles + alt_mesh->acmr_before * alt_triangles) / (base_triangles + alt_triangles);
+            final_mesh->acmr_after = acmr(final_mesh->indices, final_mesh->vertices.size());
+        }
+        final_mesh->alt_data = make_map_mesh_data(*final_mesh, final_mesh->base_num_vertices, final_mesh->vertices.size(), final_mesh->base_num_indices, final_mesh->indices.size());
     }
 
-    texture = texture != nullptr ? texture : fallback_texture;
+    texture = !texture.empty() ? texture : fallback_texture;
 
     auto map = std::make_shared<FFTMap>();
     map->mesh = final_mesh;
-    map->texture = texture;
-    map->gns_records = gns_records;
+    map->texture = std::move(texture);
+    map->gns_records = base->gns_records;
 
     return map;
 }
 
-auto BinReader::read_scenarios() -> std::vector<Scenario>
+auto BinReader::read_scenarios() const -> std::vector<Scenario>
 {
     auto attack_out = read_attack_out_file();
     auto event_file = read_event_file();
@@ -101,7 +247,7 @@ auto BinReader::read_scenarios() -> std::vector<Scenario>
     std::vector<Scenario> valid_scenarios;
     for (auto& scenario : attack_out.read_scenarios()) {
         // We only care about scenarios that have a valid event.
-        auto event = events[scenario.id()];
+        auto event = events[scenario.id];
         if (event.should_skip()) {
             continue;
         }
@@ -110,81 +256,412 @@ auto BinReader::read_scenarios() -> std::vector<Scenario>
     return valid_scenarios;
 }
 
-auto BinReader::read_events() -> std::vector<Event>
+auto BinReader::read_events() const -> std::vector<Event>
 {
     auto event_file = read_event_file();
     return event_file.read_events();
 }
 
-// read_sector reads a sector to `out_bytes`.
-auto BinReader::read_sector(int32_t sector_num) -> std::array<uint8_t, SECTOR_SIZE>
+auto BinReader::read_sector(uint32_t sector_num) const -> const uint8_t*
+{
+    size_t offset = (sector_num * SECTOR_SIZE_RAW) + SECTOR_HEADER_SIZE;
+    assert(offset + SECTOR_SIZE <= m_image_size);
+    return m_image + offset;
+}
+
+// advise passes an madvise() hint for a run of raw sectors. The range is
+// widened to page boundaries as madvise requires.
+auto BinReader::advise(uint32_t sector_num, uint32_t num_sectors, int advice) const -> void
+{
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+
+    size_t begin = sector_num * SECTOR_SIZE_RAW;
+    size_t end = std::min(begin + (num_sectors * SECTOR_SIZE_RAW), m_image_size);
+    begin -= begin % page_size;
+    madvise(const_cast<uint8_t*>(m_image) + begin, end - begin, advice);
+}
+
+// read_raw_sectors reads the user data of `num_sectors` consecutive sectors
+// into `out` with positional reads. Each chunk is read raw into a local
+// scratch buffer and then de-interleaved, so concurrent callers never share
+// any state.
+auto BinReader::read_raw_sectors(uint32_t sector_num, uint32_t num_sectors, uint8_t* out) const -> void
+{
+    std::vector<uint8_t> scratch(std::min(num_sectors, POSITIONAL_CHUNK_SECTORS) * SECTOR_SIZE_RAW);
+
+    while (num_sectors > 0) {
+        uint32_t chunk_sectors = std::min(num_sectors, POSITIONAL_CHUNK_SECTORS);
+        size_t chunk_size = chunk_sectors * SECTOR_SIZE_RAW;
+        off_t offset = (off_t)sector_num * SECTOR_SIZE_RAW;
+
+        size_t n = 0;
+        while (n < chunk_size) {
+            ssize_t r = pread(m_fd, scratch.data() + n, chunk_size - n, offset + n);
+            if (r < 0 && errno == EINTR) {
+                continue;
+            }
+            if (r < 0) {
+                fprintf(stderr, "Failed to read sector %u: %s\n", sector_num, strerror(errno));
+                exit(1);
+            }
+            if (r == 0) {
+                fprintf(stderr, "Short read at sector %u: image ends %zu bytes into a %zu byte chunk\n", sector_num, n, chunk_size);
+                exit(1);
+            }
+            n += r;
+        }
+
+        copy_user_data(scratch.data() + SECTOR_HEADER_SIZE, chunk_sectors, out);
+        out += chunk_sectors * SECTOR_SIZE;
+        sector_num += chunk_sectors;
+        num_sectors -= chunk_sectors;
+    }
+}
+
+// read_sectors reads the user data of a run of consecutive sectors. The whole
+// raw run is prefetched with a single hint (or read in a few large chunks)
+// and then de-interleaved into `out`.
+auto BinReader::read_sectors(uint32_t sector_num, uint32_t num_sectors, uint8_t* out) const -> void
+{
+    if (m_mode == ReadMode::Mapped) {
+        advise(sector_num, num_sectors, MADV_WILLNEED);
+        copy_user_data(read_sector(sector_num), num_sectors, out);
+    } else {
+        read_raw_sectors(sector_num, num_sectors, out);
+    }
+}
+
+// read_sectors_cached serves what it can from the sector cache and reads the
+// remaining runs of missing sectors in one go each.
+auto BinReader::read_sectors_cached(uint32_t sector_num, uint32_t num_sectors, uint8_t* out) const -> void
 {
-    int32_t seek_to = (sector_num * SECTOR_SIZE_RAW) + SECTOR_HEADER_SIZE;
-    if (fseek(file, seek_to, SEEK_SET) != 0) {
-        assert(false);
+    uint32_t i = 0;
+    while (i < num_sectors) {
+        if (m_cache.get(sector_num + i, out + (i * SECTOR_SIZE))) {
+            i++;
+            continue;
+        }
+
+        uint32_t run_start = i++;
+        while (i < num_sectors && !m_cache.get(sector_num + i, out + (i * SECTOR_SIZE))) {
+            i++;
+        }
+
+        // The sector that ended the run, if any, was a hit and has already
+        // been copied, so the run is exactly [run_start, i).
+        read_sectors(sector_num + run_start, i - run_start, out + (run_start * SECTOR_SIZE));
+        for (uint32_t j = run_start; j < i; j++) {
+            m_cache.put(sector_num + j, out + (j * SECTOR_SIZE));
+        }
+        i++;
+    }
+}
+
+// read_file reads an entire file into a buffer that is sized once up front.
+// Files are stored in consecutive sectors. Large one-off files like the event
+// file bypass the cache so they don't flush everything else out of it.
+auto BinReader::read_file(uint32_t sector_num, uint32_t size) const -> BinFile
+{
+    uint32_t occupied_sectors = (size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+    // A single sector's user data is contiguous in the mapped image, so the
+    // file can borrow it instead of copying.
+    if (m_mode == ReadMode::Mapped && occupied_sectors == 1) {
+        return BinFile(std::span(read_sector(sector_num), SECTOR_SIZE));
+    }
+
+    std::vector<uint8_t> data(occupied_sectors * SECTOR_SIZE);
+    if (occupied_sectors > m_cache.capacity() / 4) {
+        read_sectors(sector_num, occupied_sectors, data.data());
+    } else {
+        read_sectors_cached(sector_num, occupied_sectors, data.data());
+    }
+    return BinFile(std::move(data));
+}
+
+auto BinReader::read_files(const std::vector<FileRange>& ranges, const std::function<void(size_t, BinFile)>& on_file) const -> void
+{
+#ifdef HERETIC_IO_URING
+    if (read_files_uring(ranges, on_file)) {
+        return;
+    }
+#endif
+
+    // Queue readahead for every file before copying any of them, so the
+    // kernel can keep the device busy while the workers de-interleave.
+    if (m_mode == ReadMode::Mapped) {
+        for (const auto& range : ranges) {
+            advise(range.sector, (range.size + SECTOR_SIZE - 1) / SECTOR_SIZE, MADV_WILLNEED);
+        }
+    }
+
+    std::atomic<size_t> next = 0;
+    auto worker = [&]() {
+        for (size_t i = next++; i < ranges.size(); i = next++) {
+            on_file(i, read_file(ranges[i].sector, ranges[i].size));
+        }
+    };
+
+    size_t num_threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(ranges.size(), 1));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
     }
-    auto sector = std::array<uint8_t, SECTOR_SIZE>();
-    size_t n = fread(sector.data(), sizeof(uint8_t), SECTOR_SIZE, file);
-    assert(n == SECTOR_SIZE);
-    return sector;
 }
 
-// read_file reads an entire file, sector by sector.
-auto BinReader::read_file(uint32_t sector_num, uint32_t size) -> BinFile
+#ifdef HERETIC_IO_URING
+// read_files_uring keeps up to `queue_depth` raw sector runs in flight and
+// decodes each one on the calling thread as soon as it completes. Returns
+// false if a ring can't be created so the caller can fall back to threads.
+auto BinReader::read_files_uring(const std::vector<FileRange>& ranges, const std::function<void(size_t, BinFile)>& on_file) const -> bool
 {
-    uint32_t occupied_sectors = ceil((float)size / (float)SECTOR_SIZE);
-    std::vector<uint8_t> data;
-    for (uint32_t i = 0; i < occupied_sectors; i++) {
-        auto sector_data = read_sector(sector_num + i);
-        data.insert(data.end(), sector_data.begin(), sector_data.end());
+    constexpr unsigned queue_depth = 64;
+
+    io_uring ring;
+    if (io_uring_queue_init(queue_depth, &ring, 0) < 0) {
+        return false;
+    }
+
+    std::vector<std::vector<uint8_t>> raw(ranges.size());
+    size_t submitted = 0;
+    size_t completed = 0;
+    unsigned in_flight = 0;
+
+    while (completed < ranges.size()) {
+        while (submitted < ranges.size() && in_flight < queue_depth) {
+            io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            if (sqe == nullptr) {
+                break;
+            }
+            const auto& range = ranges[submitted];
+            uint32_t occupied_sectors = (range.size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+            raw[submitted].resize(occupied_sectors * SECTOR_SIZE_RAW);
+            io_uring_prep_read(sqe, m_fd, raw[submitted].data(), raw[submitted].size(), (off_t)range.sector * SECTOR_SIZE_RAW);
+            io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(submitted));
+            submitted++;
+            in_flight++;
+        }
+        io_uring_submit(&ring);
+
+        io_uring_cqe* cqe = nullptr;
+        int ret = io_uring_wait_cqe(&ring, &cqe);
+        if (ret == -EINTR) {
+            continue;
+        }
+        if (ret < 0) {
+            fprintf(stderr, "io_uring_wait_cqe failed: %s\n", strerror(-ret));
+            exit(1);
+        }
+
+        size_t index = reinterpret_cast<size_t>(io_uring_cqe_get_data(cqe));
+        int res = cqe->res;
+        io_uring_cqe_seen(&ring, cqe);
+        in_flight--;
+        completed++;
+
+        const auto& range = ranges[index];
+        uint32_t occupied_sectors = (range.size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+        std::vector<uint8_t> data(occupied_sectors * SECTOR_SIZE);
+        if (res == (int)raw[index].size()) {
+            copy_user_data(raw[index].data() + SECTOR_HEADER_SIZE, occupied_sectors, data.data());
+        } else {
+            // Short reads only happen at the end of a truncated image, and
+            // errors are rare enough to just retry synchronously.
+            read_raw_sectors(range.sector, occupied_sectors, data.data());
+        }
+        raw[index] = {};
+
+        on_file(index, BinFile(std::move(data)));
     }
 
-    BinFile out_file(data);
-    return out_file;
+    io_uring_queue_exit(&ring);
+    return true;
 }
+#endif
 
-auto BinReader::read_texture_file(uint32_t sector_num) -> TextureFile
+auto BinReader::read_all_records() const -> std::map<int, std::vector<Record>>
+{
+    std::vector<int> map_nums;
+    std::vector<FileRange> ranges;
+    for (const auto& [map_num, desc] : map_list) {
+        if (desc.valid) {
+            map_nums.push_back(map_num);
+            ranges.push_back({ desc.sector, GNS_MAX_SIZE });
+        }
+    }
+
+    std::map<int, std::vector<Record>> all_records;
+    std::mutex mutex;
+    read_files(ranges, [&](size_t i, BinFile file) {
+        auto records = GNSFile { std::move(file) }.read_records();
+        std::lock_guard<std::mutex> lock(mutex);
+        all_records[map_nums[i]] = std::move(records);
+    });
+    return all_records;
+}
+
+auto BinReader::read_texture_file(uint32_t sector_num) const -> TextureFile
 {
     return TextureFile { read_file(sector_num, FFT_TEXTURE_RAW_SIZE) };
 }
 
-auto BinReader::read_mesh_file(uint32_t sector_num, uint32_t size) -> MeshFile
+auto BinReader::read_mesh_file(uint32_t sector_num, uint32_t size) const -> MeshFile
 {
     return MeshFile { read_file(sector_num, size) };
 }
 
-auto BinReader::read_gns_file(uint32_t sector_num) -> GNSFile
+auto BinReader::read_gns_file(uint32_t sector_num) const -> GNSFile
 {
     return GNSFile { read_file(sector_num, GNS_MAX_SIZE) };
 }
 
-auto BinReader::read_attack_out_file() -> AttackOutFile
+auto BinReader::read_attack_out_file() const -> AttackOutFile
+{
+    return AttackOutFile { read_file("EVENT/ATTACK.OUT") };
+}
+
+auto BinReader::read_event_file() const -> EventFile
 {
-    constexpr int attack_out_sector = 2448;
-    constexpr int attack_out_size = 125956;
+    return EventFile { read_file("EVENT/TEST.EVT") };
+}
 
-    return AttackOutFile { read_file(attack_out_sector, attack_out_size) };
+auto BinReader::read_file(const std::string& path) const -> BinFile
+{
+    auto range = m_index.find(path);
+    if (!range) {
+        fprintf(stderr, "File not found on disc: %s\n", path.c_str());
+        exit(1);
+    }
+    return read_file(range->sector, range->size);
 }
 
-auto BinReader::read_event_file() -> EventFile
+// build_index walks the ISO9660 directory tree starting at the root directory
+// record of the primary volume descriptor.
+auto BinReader::build_index() const -> DiscIndex
 {
-    constexpr int event_file_sector = 3707;
-    constexpr int event_file_size = 4096000;
+    DiscIndex index;
+
+    auto pvd = read_file(ISO_PRIMARY_VOLUME_DESCRIPTOR_SECTOR, SECTOR_SIZE);
+    if (pvd.read_u8() != 0x01) {
+        fprintf(stderr, "Missing ISO9660 primary volume descriptor\n");
+        return index;
+    }
+
+    struct Directory {
+        std::string path;
+        FileRange range;
+    };
+
+    auto read_record_range = [](BinFile& file, uint64_t record_offset) -> FileRange {
+        // Extent and length are stored both-endian, little endian first.
+        file.seek(record_offset + 2);
+        uint32_t sector = file.read_u32();
+        file.seek(record_offset + 10);
+        uint32_t size = file.read_u32();
+        return { sector, size };
+    };
 
-    return EventFile { read_file(event_file_sector, event_file_size) };
+    std::vector<Directory> pending = { { "", read_record_range(pvd, ISO_ROOT_DIRECTORY_RECORD_OFFSET) } };
+    std::vector<uint32_t> visited;
+
+    while (!pending.empty()) {
+        auto directory = pending.back();
+        pending.pop_back();
+
+        if (std::find(visited.begin(), visited.end(), directory.range.sector) != visited.end()) {
+            continue;
+        }
+        visited.push_back(directory.range.sector);
+
+        auto file = read_file(directory.range.sector, directory.range.size);
+        uint64_t offset = 0;
+        while (offset < directory.range.size) {
+            file.seek(offset);
+            uint8_t record_length = file.read_u8();
+
+            // Records never cross a sector boundary. The rest of the sector
+            // is zero padded.
+            if (record_length == 0) {
+                offset = ((offset / SECTOR_SIZE) + 1) * SECTOR_SIZE;
+                continue;
+            }
+
+            auto range = read_record_range(file, offset);
+            file.seek(offset + 25);
+            uint8_t flags = file.read_u8();
+            file.seek(offset + 32);
+            uint8_t name_length = file.read_u8();
+            auto name_bytes = file.read_bytes(name_length);
+            offset += record_length;
+
+            // 0x00 and 0x01 are the "." and ".." entries.
+            if (name_length == 1 && name_bytes[0] <= 0x01) {
+                continue;
+            }
+
+            std::string name(name_bytes.begin(), name_bytes.end());
+            auto version = name.find(';');
+            if (version != std::string::npos) {
+                name.erase(version);
+            }
+
+            auto path = directory.path.empty() ? name : directory.path + "/" + name;
+            if (flags & ISO_DIRECTORY_FLAG) {
+                pending.push_back({ path, range });
+            } else {
+                index.add(path, range);
+            }
+        }
+    }
+
+    return index;
+}
+
+// copy_user_data strips the 24 byte header and the 280 byte EDC/ECC trailer
+// from `num_sectors` consecutive raw sectors, writing only the user data to
+// `out`. `user_data` points at the user data of the first sector. Each copy is
+// a fixed SECTOR_SIZE block, which the compiler lowers to wide vector moves.
+auto copy_user_data(const uint8_t* user_data, uint32_t num_sectors, uint8_t* out) -> void
+{
+    for (uint32_t i = 0; i < num_sectors; i++) {
+        std::memcpy(out, user_data, SECTOR_SIZE);
+        user_data += SECTOR_SIZE_RAW;
+        out += SECTOR_SIZE;
+    }
 }
 
 auto merge_meshes(std::shared_ptr<FFTMesh> destination, std::shared_ptr<FFTMesh> source) -> void
 {
     if (!source->vertices.empty()) {
+        size_t base = destination->vertices.size();
+        assert(base + source->vertices.size() <= UINT16_MAX + 1);
         destination->vertices.insert(destination->vertices.end(), source->vertices.begin(), source->vertices.end());
+        for (uint16_t index : source->indices) {
+            destination->indices.push_back(base + index);
+        }
+
+        uint16_t polygon_base = 0;
+        if (!destination->polygons.empty()) {
+            polygon_base = *std::max_element(destination->polygons.begin(), destination->polygons.end()) + 1;
+        }
+        for (uint16_t polygon : source->polygons) {
+            destination->polygons.push_back(polygon_base + polygon);
+        }
     }
 
     if (!source->lights.empty()) {
         destination->lights = source->lights;
     }
 
-    if (source->palette != nullptr) {
+    if (source->terrain.is_valid()) {
+        destination->terrain = source->terrain;
+    }
+
+    if (!source->palette.empty()) {
         destination->palette = source->palette;
     }
 
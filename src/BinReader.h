@@ -2,43 +2,147 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <glm/glm.hpp>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "BinFile.h"
+#include "DiscIndex.h"
 #include "Event.h"
 #include "Scenario.h"
+#include "SectorCache.h"
+
+// Default size of the sector cache. 2048 sectors is 4 MiB, which holds the
+// GNS file, textures and meshes of a couple of maps in all their styles.
+constexpr size_t SECTOR_CACHE_DEFAULT_CAPACITY = 2048;
+
+// Number of map bases kept by BinReader. Each is one map's decoded primary
+// and override meshes, a few hundred KiB.
+constexpr size_t MAP_BASE_CACHE_CAPACITY = 8;
+
+// MapBase is the part of a map that is the same for every style: its GNS
+// records and the primary and override meshes, merged and optimized.
+struct MapBase {
+    std::vector<Record> gns_records = {};
+    std::shared_ptr<const FFTMesh> mesh = nullptr;
+};
+
+// ReadMode selects how BinReader gets at the image.
+enum class ReadMode {
+    // Map the whole image once. Reads are pointer arithmetic and a memcpy.
+    Mapped,
+    // pread() the raw sectors in bounded chunks. Used when the image can't
+    // be mapped.
+    Positional,
+};
 
 // Binary file read for Final Fantasy Tactics PSX (Original and Greatest Hits)
 //
 // Serial: SCUS-94221
 // md5sum: b156ba386436d20fd5ed8d37bab6b624
+//
+// BinReader holds no seek position. Its only mutable state, the sector cache
+// and the cache of map bases, is internally synchronized, so a single
+// instance can be shared by any number of threads reading files
+// concurrently, including read_map(), which only produces CPU-side data.
 class BinReader {
 public:
-    explicit BinReader(std::string filename);
+    explicit BinReader(std::string filename, ReadMode mode = ReadMode::Mapped);
     ~BinReader();
 
-    auto read_map(int mapnum, MapTime time, MapWeather weather, int arrangement) -> std::shared_ptr<FFTMap>;
-    auto read_scenarios() -> std::vector<Scenario>;
-    auto read_events() -> std::vector<Event>;
+    BinReader(const BinReader&) = delete;
+    BinReader& operator=(const BinReader&) = delete;
+
+    auto read_map(int mapnum, MapTime time, MapWeather weather, int arrangement) const -> std::shared_ptr<FFTMap>;
+
+    // read_map_base returns the style independent part of a map. The last
+    // few are cached, so switching styles of a map only reads and decodes
+    // that style's MeshAlt and Texture.
+    auto read_map_base(int map_num) const -> std::shared_ptr<const MapBase>;
+    auto read_scenarios() const -> std::vector<Scenario>;
+    auto read_events() const -> std::vector<Event>;
+
+    // read_file reads any file on the disc by its ISO9660 path, e.g.
+    // "EVENT/ATTACK.OUT". See DiscIndex for the path format.
+    //
+    // Files may borrow their bytes from the mapped image, so a BinFile must
+    // not outlive the BinReader it came from.
+    auto read_file(const std::string& path) const -> BinFile;
+    auto find_file(const std::string& path) const -> std::optional<FileRange> { return m_index.find(path); }
+
+    // read_files reads a batch of files for whole-disc scans. All reads are
+    // issued up front and `on_file` is called with each file's index into
+    // `ranges` as it completes, in no particular order. `on_file` may be
+    // called concurrently from several threads.
+    auto read_files(const std::vector<FileRange>& ranges, const std::function<void(size_t, BinFile)>& on_file) const -> void;
+
+    // read_all_records reads the GNS records of every valid map.
+    auto read_all_records() const -> std::map<int, std::vector<Record>>;
+
+    auto mode() const -> ReadMode { return m_mode; }
+
+    // fingerprint identifies the disc image by a hash of its primary volume
+    // descriptor, which includes the volume id and creation date.
+    auto fingerprint() const -> std::string { return m_fingerprint; }
+
+    // The sector cache keeps recently read sectors in memory, so switching
+    // back and forth between styles of a map doesn't touch the disc.
+    auto cache_stats() const -> SectorCacheStats { return m_cache.stats(); }
+    auto set_cache_capacity(size_t sectors) -> void { m_cache.set_capacity(sectors); }
+
+    // read_mesh_file reads a mesh by its GNS record's sector and length.
+    auto read_mesh_file(uint32_t sector, uint32_t size) const -> MeshFile;
 
 private:
-    auto read_sector(int32_t sector_num) -> std::array<uint8_t, SECTOR_SIZE>;
-    auto read_file(uint32_t sector, uint32_t size) -> BinFile;
+    // read_sector returns a view of the sector's user data (SECTOR_SIZE bytes)
+    // directly from the mapped image. Nothing is copied. Mapped mode only.
+    auto read_sector(uint32_t sector_num) const -> const uint8_t*;
+    auto advise(uint32_t sector_num, uint32_t num_sectors, int advice) const -> void;
+    auto read_raw_sectors(uint32_t sector_num, uint32_t num_sectors, uint8_t* out) const -> void;
+    auto read_sectors(uint32_t sector_num, uint32_t num_sectors, uint8_t* out) const -> void;
+    auto read_sectors_cached(uint32_t sector_num, uint32_t num_sectors, uint8_t* out) const -> void;
+    auto read_file(uint32_t sector, uint32_t size) const -> BinFile;
+    auto build_index() const -> DiscIndex;
+#ifdef HERETIC_IO_URING
+    auto read_files_uring(const std::vector<FileRange>& ranges, const std::function<void(size_t, BinFile)>& on_file) const -> bool;
+#endif
 
     // File types to read
-    auto read_gns_file(uint32_t sector) -> GNSFile;
-    auto read_texture_file(uint32_t sector) -> TextureFile;
-    auto read_mesh_file(uint32_t sector, uint32_t size) -> MeshFile;
+    auto read_gns_file(uint32_t sector) const -> GNSFile;
+    auto read_texture_file(uint32_t sector) const -> TextureFile;
 
     // Specific Files on disk
-    auto read_attack_out_file() -> AttackOutFile;
-    auto read_event_file() -> EventFile;
+    auto read_attack_out_file() const -> AttackOutFile;
+    auto read_event_file() const -> EventFile;
 
 private:
-    FILE* file;
+    ReadMode m_mode = ReadMode::Mapped;
+
+    // Used for Positional mode and batched reads. pread() and io_uring take
+    // the offset explicitly, so the descriptor's own file position is never
+    // touched.
+    int m_fd = -1;
+
+    // The whole raw image (SECTOR_SIZE_RAW byte sectors) is mapped read-only
+    // once. Sector reads are just pointer arithmetic into it.
+    const uint8_t* m_image = nullptr;
+    size_t m_image_size = 0;
+
+    DiscIndex m_index = {};
+    std::string m_fingerprint = {};
+
+    mutable SectorCache m_cache { SECTOR_CACHE_DEFAULT_CAPACITY };
+
+    // Most recently used map bases are at the front.
+    mutable std::mutex m_bases_mutex;
+    mutable std::list<std::pair<int, std::shared_ptr<const MapBase>>> m_bases = {};
 };
 
+auto copy_user_data(const uint8_t* user_data, uint32_t num_sectors, uint8_t* out) -> void;
 auto merge_meshes(std::shared_ptr<FFTMesh> primary_mesh, std::shared_ptr<FFTMesh> other_mesh) -> void;
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BinReader.h"
+#include "CookedCache.h"
+
+// Bump COOKED_VERSION whenever the layout of the file or of any struct
+// written into it changes. Stale files are then ignored and re-cooked.
+constexpr char COOKED_MAGIC[8] = { 'H', 'R', 'T', 'C', 'O', 'O', 'K', 'D' };
+constexpr uint32_t COOKED_VERSION = 10;
+
+// Sections start on a 16 byte boundary so every array in them is aligned.
+constexpr size_t COOKED_ALIGNMENT = 16;
+
+struct CookedSection {
+    uint64_t offset;
+    uint64_t size;
+};
+
+// CookedMeshData is a MapMeshData. Its sections are used in place.
+struct CookedMeshData {
+    CookedSection vertices;
+    CookedSection indices;
+    CookedSection chunks;
+    AABB aabb;
+    BoundingSphere sphere;
+};
+
+struct CookedHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertex_size;
+
+    glm::vec4 ambient_color;
+    glm::vec4 background_top;
+    glm::vec4 background_bottom;
+    float acmr_before;
+    float acmr_after;
+    uint32_t base_num_vertices;
+    uint32_t base_num_indices;
+
+    CookedSection vertices;
+    CookedSection indices;
+    CookedSection polygons;
+    CookedSection texture;
+    CookedSection palette;
+    CookedSection lights;
+    CookedSection terrain;
+    CookedSection records;
+    CookedMeshData base_data;
+    CookedMeshData alt_data;
+};
+
+static_assert(std::is_trivially_copyable_v<CookedHeader>);
+static_assert(std::is_trivially_copyable_v<Vertex>);
+static_assert(std::is_trivially_copyable_v<LightData>);
+static_assert(std::is_trivially_copyable_v<Record>);
+static_assert(std::is_trivially_copyable_v<Terrain>);
+static_assert(std::is_trivially_copyable_v<MapVertex>);
+static_assert(std::is_trivially_copyable_v<MeshChunk>);
+
+auto MapKey::repr() const -> std::string
+{
+    std::ostringstream oss;
+    oss << map_num << " " << to_string(time) << " " << to_string(weather) << " " << arrangement;
+    return oss.str();
+}
+
+auto MapKey::operator==(const MapKey& other) const -> bool
+{
+    return std::tie(map_num, time, weather, arrangement) == std::tie(other.map_num, other.time, other.weather, other.arrangement);
+}
+
+CookedCache::CookedCache(std::string directory, std::string fingerprint)
+    : m_directory(directory + "/" + fingerprint)
+{
+}
+
+auto CookedCache::path(const MapKey& key) const -> std::string
+{
+    char filename[64];
+    snprintf(filename, sizeof(filename), "%03d_%d_%d_%d.cooked", key.map_num, (int)key.time, (int)key.weather, key.arrangement);
+    return m_directory + "/" + filename;
+}
+
+// load maps the file and checks it. The CPU-side sections are copied into
+// the map, but the base and alt mesh data point into the mapping, which
+// lives as long as the map, so uploading them reads the file directly.
+auto CookedCache::load(const MapKey& key) const -> std::shared_ptr<FFTMap>
+{
+    int fd = open(path(key).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CookedHeader)) {
+        close(fd);
+        return nullptr;
+    }
+    size_t file_size = st.st_size;
+
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    std::shared_ptr<const void> storage(mapping, [file_size](const void* address) { munmap(const_cast<void*>(address), file_size); });
+    const auto* bytes = static_cast<const uint8_t*>(mapping);
+
+    CookedHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    auto section_ok = [&](const CookedSection& section, size_t element_size) {
+        return section.offset <= file_size && section.size <= file_size - section.offset && section.size % element_size == 0;
+    };
+
+    // Mesh data is used in place, so its sections must be aligned, and it
+    // goes to the GPU, so every index and chunk must be in range.
+    auto mesh_data_ok = [&](const CookedMeshData& data, size_t num_vertices, size_t num_indices) {
+        bool ok = section_ok(data.vertices, sizeof(MapVertex))
+            && section_ok(data.indices, sizeof(uint16_t))
+            && section_ok(data.chunks, sizeof(MeshChunk))
+            && data.vertices.offset % COOKED_ALIGNMENT == 0
+            && data.indices.offset % COOKED_ALIGNMENT == 0
+            && data.chunks.offset % COOKED_ALIGNMENT == 0
+            && data.vertices.size / sizeof(MapVertex) == num_vertices
+            && data.indices.size / sizeof(uint16_t) == num_indices;
+        if (!ok) {
+            return false;
+        }
+        const auto* indices = reinterpret_cast<const uint16_t*>(bytes + data.indices.offset);
+        for (size_t i = 0; i < num_indices; i++) {
+            if (indices[i] >= num_vertices) {
+                return false;
+            }
+        }
+        const auto* chunks = reinterpret_cast<const MeshChunk*>(bytes + data.chunks.offset);
+        for (size_t i = 0; i < data.chunks.size / sizeof(MeshChunk); i++) {
+            if (chunks[i].first_index > num_indices || chunks[i].num_indices > num_indices - chunks[i].first_index) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    bool ok = std::memcmp(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC)) == 0
+        && header.version == COOKED_VERSION
+        && header.vertex_size == sizeof(Vertex)
+        && section_ok(header.vertices, sizeof(Vertex))
+        && section_ok(header.indices, sizeof(uint16_t))
+        && section_ok(header.polygons, sizeof(uint16_t))
+        && section_ok(header.texture, FFT_TEXTURE_NUM_BYTES)
+        && section_ok(header.palette, FFT_PALETTE_NUM_BYTES)
+        && section_ok(header.lights, sizeof(LightData))
+        && section_ok(header.terrain, sizeof(Terrain))
+        && header.terrain.size <= sizeof(Terrain)
+        && header.base_num_vertices <= header.vertices.size / sizeof(Vertex)
+        && header.base_num_indices <= header.indices.size / sizeof(uint16_t)
+        && section_ok(header.records, sizeof(Record));
+
+    size_t num_vertices = header.vertices.size / sizeof(Vertex);
+    size_t num_indices = header.indices.size / sizeof(uint16_t);
+    ok = ok
+        && mesh_data_ok(header.base_data, header.base_num_vertices, header.base_num_indices)
+        && mesh_data_ok(header.alt_data, num_vertices - header.base_num_vertices, num_indices - header.base_num_indices);
+
+    if (!ok) {
+        return nullptr;
+    }
+
+    auto section_bytes = [&](const CookedSection& section) {
+        return std::vector<uint8_t>(bytes + section.offset, bytes + section.offset + section.size);
+    };
+
+    auto mesh_data = [&](const CookedMeshData& cooked) -> MapMeshData {
+        MapMeshData data = {};
+        if (cooked.indices.size == 0) {
+            return data;
+        }
+        data.vertices = { reinterpret_cast<const MapVertex*>(bytes + cooked.vertices.offset), cooked.vertices.size / sizeof(MapVertex) };
+        data.indices = { reinterpret_cast<const uint16_t*>(bytes + cooked.indices.offset), cooked.indices.size / sizeof(uint16_t) };
+        data.chunks = { reinterpret_cast<const MeshChunk*>(bytes + cooked.chunks.offset), cooked.chunks.size / sizeof(MeshChunk) };
+        data.aabb = cooked.aabb;
+        data.sphere = cooked.sphere;
+        data.storage = storage;
+        return data;
+    };
+
+    // copy_section fills a vector with a section's elements. Empty vectors
+    // may have no data() to copy into.
+    auto copy_section = [&](const CookedSection& section, auto& out) {
+        out.resize(section.size / sizeof(out[0]));
+        if (section.size > 0) {
+            std::memcpy(out.data(), bytes + section.offset, section.size);
+        }
+    };
+
+    auto mesh = std::make_shared<FFTMesh>();
+    copy_section(header.vertices, mesh->vertices);
+    copy_section(header.indices, mesh->indices);
+    copy_section(header.polygons, mesh->polygons);
+    copy_section(header.lights, mesh->lights);
+    mesh->palette = section_bytes(header.palette);
+    std::memcpy(&mesh->terrain, bytes + header.terrain.offset, header.terrain.size);
+    mesh->ambient_color = header.ambient_color;
+    mesh->background = { header.background_top, header.background_bottom };
+    mesh->acmr_before = header.acmr_before;
+    mesh->acmr_after = header.acmr_after;
+    mesh->base_num_vertices = header.base_num_vertices;
+    mesh->base_num_indices = header.base_num_indices;
+    mesh->base_data = mesh_data(header.base_data);
+    mesh->alt_data = mesh_data(header.alt_data);
+
+    auto map = std::make_shared<FFTMap>();
+    map->mesh = mesh;
+    map->texture = section_bytes(header.texture);
+    copy_section(header.records, map->gns_records);
+
+    return map;
+}
+
+auto CookedCache::store(const MapKey& key, const FFTMap& map) const -> bool
+{
+    std::vector<uint8_t> out(sizeof(CookedHeader));
+
+    auto append = [&](const void* data, size_t size) -> CookedSection {
+        out.resize((out.size() + COOKED_ALIGNMENT - 1) / COOKED_ALIGNMENT * COOKED_ALIGNMENT);
+        CookedSection section = { out.size(), size };
+        out.insert(out.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        return section;
+    };
+
+    CookedHeader header = {};
+    std::memcpy(header.magic, COOKED_MAGIC, sizeof(COOKED_MAGIC));
+    header.version = COOKED_VERSION;
+    header.vertex_size = sizeof(Vertex);
+    header.ambient_color = map.mesh->ambient_color;
+    header.background_top = map.mesh->background.first;
+    header.background_bottom = map.mesh->background.second;
+    header.acmr_before = map.mesh->acmr_before;
+    header.acmr_after = map.mesh->acmr_after;
+    header.base_num_vertices = map.mesh->base_num_vertices;
+    header.base_num_indices = map.mesh->base_num_indices;
+    header.vertices = append(map.mesh->vertices.data(), map.mesh->vertices.size() * sizeof(Vertex));
+    header.indices = append(map.mesh->indices.data(), map.mesh->indices.size() * sizeof(uint16_t));
+    header.polygons = append(map.mesh->polygons.data(), map.mesh->polygons.size() * sizeof(uint16_t));
+    header.texture = append(map.texture.data(), map.texture.size());
+    header.palette = append(map.mesh->palette.data(), map.mesh->palette.size());
+    header.lights = append(map.mesh->lights.data(), map.mesh->lights.size() * sizeof(LightData));
+    header.terrain = append(&map.mesh->terrain, map.mesh->terrain.is_valid() ? sizeof(Terrain) : 0);
+    header.records = append(map.gns_records.data(), map.gns_records.size() * sizeof(Record));
+
+    auto append_mesh_data = [&](const MapMeshData& data) -> CookedMeshData {
+        auto vertices = append(data.vertices.data(), data.vertices.size_bytes());
+        auto indices = append(data.indices.data(), data.indices.size_bytes());
+        auto chunks = append(data.chunks.data(), data.chunks.size_bytes());
+        return { vertices, indices, chunks, data.aabb, data.sphere };
+    };
+    header.base_data = append_mesh_data(map.mesh->base_data);
+    header.alt_data = append_mesh_data(map.mesh->alt_data);
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    // Write to a temporary file and rename it into place, so a reader (or a
+    // concurrent cook of the same map) never sees a partial file.
+    static std::atomic<uint32_t> counter = 0;
+    auto final_path = path(key);
+    auto temp_path = final_path + "." + std::to_string(getpid()) + "." + std::to_string(counter++) + ".tmp";
+
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = fclose(file) == 0 && ok;
+    ok = ok && std::rename(temp_path.c_str(), final_path.c_str()) == 0;
+    if (!ok) {
+        std::remove(temp_path.c_str());
+    }
+    return ok;
+}
+
+auto CookedCache::load_or_cook(const BinReader& reader, const MapKey& key) const -> std::shared_ptr<FFTMap>
+{
+    auto map = load(key);
+    if (map != nullptr) {
+        return map;
+    }
+
+    map = reader.read_map(key.map_num, key.time, key.weather, key.arrangement);
+    if (map != nullptr && !store(key, *map)) {
+        std::cout << "Failed to cook map: " << key.repr() << std::endl;
+    }
+    return map;
+}
+
+auto CookedCache::cook_all(const BinReader& reader, unsigned num_threads) const -> void
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Every map can be shown in its default style, plus each style that has
+    // a GNS record.
+    std::vector<MapKey> keys;
+    for (const auto& [map_num, records] : reader.read_all_records()) {
+        keys.push_back({ map_num });
+        for (const auto& record : records) {
+            MapKey key = { map_num, record.time, record.weather, record.arrangement };
+            if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+                keys.push_back(key);
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> cooked = 0;
+    auto worker = [&]() {
+        for (size_t i = next++; i < keys.size(); i = next++) {
+            auto map = reader.read_map(keys[i].map_num, keys[i].time, keys[i].weather, keys[i].arrangement);
+            bool ok = map != nullptr && store(keys[i], *map);
+            cooked += ok;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ok) {
+                std::cout << "Cooked map: " << keys[i].repr() << " ACMR " << map->mesh->acmr_before << " -> " << map->mesh->acmr_after << std::endl;
+            } else {
+                std::cout << "Failed to cook map: " << keys[i].repr() << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < std::max(num_threads, 1u); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    std::cout << "Cooked " << cooked << " of " << keys.size() << " maps in " << elapsed.count() << "ms" << std::endl;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "FFT.h"
+
+class BinReader;
+
+// MapKey identifies one style of a map.
+struct MapKey {
+    int map_num;
+    MapTime time = MapTime::Day;
+    MapWeather weather = MapWeather::None;
+    int arrangement = 0;
+
+    auto repr() const -> std::string;
+    auto operator==(const MapKey& other) const -> bool;
+};
+
+// CookedCache stores fully decoded maps on disk: final vertices and indices,
+// R8 texture, RGBA8 palette, lights, background and GNS records, plus the
+// base and alt meshes laid out for upload (MapMeshData). Each cooked map is a
+// single file of raw sections. A warm load maps it, copies the CPU-side
+// sections and hands the mesh data sections to the GPU upload in place,
+// instead of reading and decoding the packed PSX data again.
+//
+// Cooked maps are stored under `<directory>/<fingerprint>/`, so caches built
+// from different discs never mix.
+class CookedCache {
+public:
+    CookedCache(std::string directory, std::string fingerprint);
+
+    auto load(const MapKey& key) const -> std::shared_ptr<FFTMap>;
+    auto store(const MapKey& key, const FFTMap& map) const -> bool;
+
+    // load_or_cook returns the cooked map if there is one, otherwise it reads
+    // the map from the disc and cooks it for next time.
+    auto load_or_cook(const BinReader& reader, const MapKey& key) const -> std::shared_ptr<FFTMap>;
+
+    // cook_all cooks every style of every valid map on the disc using
+    // `num_threads` workers.
+    auto cook_all(const BinReader& reader, unsigned num_threads) const -> void;
+
+private:
+    auto path(const MapKey& key) const -> std::string;
+
+    std::string m_directory;
+};
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "DiscIndex.h"
+
+// Bump this when the cache layout changes.
+constexpr char INDEX_MAGIC[8] = { 'H', 'R', 'T', 'I', 'D', 'X', '0', '1' };
+
+// The smallest entry is an empty path with its length, sector and size.
+constexpr size_t INDEX_MIN_ENTRY_SIZE = sizeof(uint16_t) + sizeof(uint32_t) * 2;
+
+static auto normalize_path(std::string path) -> std::string
+{
+    if (!path.empty() && path[0] == '/') {
+        path.erase(0, 1);
+    }
+    std::transform(path.begin(), path.end(), path.begin(), [](unsigned char c) { return std::toupper(c); });
+    return path;
+}
+
+auto DiscIndex::add(std::string path, FileRange range) -> void
+{
+    m_entries[normalize_path(std::move(path))] = range;
+}
+
+auto DiscIndex::find(const std::string& path) const -> std::optional<FileRange>
+{
+    auto it = m_entries.find(normalize_path(path));
+    if (it == m_entries.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+// The cache file is:
+//
+//   magic[8] image_size:u64 image_mtime:i64 count:u32
+//   count * { path_length:u16 path[path_length] sector:u32 size:u32 }
+//
+// in host byte order. It is only ever read on the machine that wrote it.
+auto DiscIndex::load(const std::string& filename, uint64_t image_size, int64_t image_mtime) -> bool
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    long file_size = 0;
+    if (fseek(file, 0, SEEK_END) != 0 || (file_size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return false;
+    }
+
+    char magic[8] = {};
+    uint64_t cached_size = 0;
+    int64_t cached_mtime = 0;
+    uint32_t count = 0;
+    bool ok = fread(magic, sizeof(magic), 1, file) == 1
+        && fread(&cached_size, sizeof(cached_size), 1, file) == 1
+        && fread(&cached_mtime, sizeof(cached_mtime), 1, file) == 1
+        && fread(&count, sizeof(count), 1, file) == 1
+        && std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) == 0
+        && cached_size == image_size
+        && cached_mtime == image_mtime
+        && count <= (size_t)file_size / INDEX_MIN_ENTRY_SIZE;
+
+    std::unordered_map<std::string, FileRange> entries;
+    if (ok) {
+        entries.reserve(count);
+    }
+    for (uint32_t i = 0; ok && i < count; i++) {
+        uint16_t path_length = 0;
+        FileRange range = {};
+        ok = fread(&path_length, sizeof(path_length), 1, file) == 1;
+        std::string path(path_length, '\0');
+        ok = ok && fread(path.data(), 1, path_length, file) == path_length
+            && fread(&range.sector, sizeof(range.sector), 1, file) == 1
+            && fread(&range.size, sizeof(range.size), 1, file) == 1;
+        entries[path] = range;
+    }
+    fclose(file);
+
+    if (ok) {
+        m_entries = std::move(entries);
+    }
+    return ok;
+}
+
+auto DiscIndex::save(const std::string& filename, uint64_t image_size, int64_t image_mtime) const -> bool
+{
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    uint32_t count = m_entries.size();
+    bool ok = fwrite(INDEX_MAGIC, sizeof(INDEX_MAGIC), 1, file) == 1
+        && fwrite(&image_size, sizeof(image_size), 1, file) == 1
+        && fwrite(&image_mtime, sizeof(image_mtime), 1, file) == 1
+        && fwrite(&count, sizeof(count), 1, file) == 1;
+
+    for (const auto& [path, range] : m_entries) {
+        uint16_t path_length = path.size();
+        ok = ok && fwrite(&path_length, sizeof(path_length), 1, file) == 1
+            && fwrite(path.data(), 1, path_length, file) == path_length
+            && fwrite(&range.sector, sizeof(range.sector), 1, file) == 1
+            && fwrite(&range.size, sizeof(range.size), 1, file) == 1;
+    }
+
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(filename.c_str());
+    }
+    return ok;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// FileRange locates a file on the disc.
+struct FileRange {
+    uint32_t sector;
+    uint32_t size;
+};
+
+// DiscIndex is a flat path -> FileRange lookup of every file on the disc,
+// built from the ISO9660 directory tree. Paths are upper case, separated by
+// '/', have no leading slash and no ";1" version suffix, e.g.
+// "EVENT/ATTACK.OUT".
+//
+// https://wiki.osdev.org/ISO_9660
+class DiscIndex {
+public:
+    auto add(std::string path, FileRange range) -> void;
+    auto find(const std::string& path) const -> std::optional<FileRange>;
+    auto size() const -> size_t { return m_entries.size(); }
+
+    // The index is cached next to the image. `image_size` and `image_mtime`
+    // identify the image it was built from, so a changed image is walked
+    // again instead of trusting a stale cache.
+    auto load(const std::string& filename, uint64_t image_size, int64_t image_mtime) -> bool;
+    auto save(const std::string& filename, uint64_t image_size, int64_t image_mtime) const -> bool;
+
+private:
+    std::unordered_map<std::string, FileRange> m_entries = {};
+};
+
+// ISO9660 layout constants.
+constexpr uint32_t ISO_PRIMARY_VOLUME_DESCRIPTOR_SECTOR = 16;
+constexpr size_t ISO_ROOT_DIRECTORY_RECORD_OFFSET = 156;
+constexpr uint8_t ISO_DIRECTORY_FLAG = 0x02;
@@ -33,7 +33,7 @@ auto Instruction::param_int(int index) const -> int
     return static_cast<int>(signed_value);
 }
 
-Event::Event(std::vector<uint8_t> data)
+Event::Event(std::span<const uint8_t> data)
 {
     m_text_offset = static_cast<uint32_t>((data[0] & 0xFF) | ((data[1] & 0xFF) << 8) | ((data[2] & 0xFF) << 16) | ((data[3] & 0xFF) << 24));
 
@@ -30,7 +30,7 @@ public:
 class Event {
 public:
     Event() = default;
-    Event(std::vector<uint8_t> data);
+    explicit Event(std::span<const uint8_t> data);
 
     auto should_skip() -> bool { return m_should_skip; }
 
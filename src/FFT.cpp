@@ -2,18 +2,18 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <iomanip>
 #include <optional>
 #include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <tuple>
 #include <utility>
 
-#include "ResourceManager.h"
 
 #include "FFT.h"
-#include "Texture.h"
 
 auto FFTMapDesc::repr() const -> std::string
 {
@@ -23,68 +23,26 @@ auto FFTMapDesc::repr() const -> std::string
     return oss.str();
 }
 
-auto Record::repr() -> std::string
+Record::Record(std::span<const uint8_t> bytes)
 {
-    std::ostringstream oss;
-    oss << to_string(time()) << " " << to_string(weather()) << " " << arrangement();
-    return oss.str();
-}
+    assert(bytes.size() >= GNS_RECORD_SIZE);
+    const uint8_t* raw = bytes.data();
+    uint8_t style = raw[GNSRecordLayout::style];
 
-auto Record::sector() -> int
-{
-    return data[8] | (data[9] << 8);
+    resource_type = static_cast<ResourceType>(raw[GNSRecordLayout::resource_type] | (raw[GNSRecordLayout::resource_type + 1] << 8));
+    sector = raw[GNSRecordLayout::sector] | (raw[GNSRecordLayout::sector + 1] << 8);
+    std::memcpy(&length, raw + GNSRecordLayout::length, sizeof(length));
+    time = static_cast<MapTime>((style >> 7) & 0x1);
+    weather = static_cast<MapWeather>((style >> 4) & 0x7);
+    arrangement = raw[GNSRecordLayout::arrangement];
+    style_key = ::style_key(time, weather, arrangement);
 }
 
-auto Record::length() -> uint64_t
+auto Record::repr() const -> std::string
 {
-    return static_cast<uint32_t>(data[12]) | (static_cast<uint32_t>(data[13]) << 8) | (static_cast<uint32_t>(data[14]) << 16) | (static_cast<uint32_t>(data[15]) << 24);
-}
-
-auto Record::resource_type() -> ResourceType
-{
-    return static_cast<ResourceType>(data[4] | (data[5] << 8));
-}
-
-auto Record::arrangement() const -> int
-{
-    return data[2];
-}
-
-auto Record::time() const -> MapTime
-{
-    return static_cast<MapTime>((data[3] >> 7) & 0x1);
-}
-
-auto Record::weather() const -> MapWeather
-{
-    return static_cast<MapWeather>((data[3] >> 4) & 0x7);
-}
-
-auto Record::operator<(const Record& other) const -> bool
-{
-    auto t = time();
-    auto w = weather();
-    auto a = arrangement();
-
-    auto ot = other.time();
-    auto ow = other.weather();
-    auto oa = other.arrangement();
-
-    return std::tie(t, w, a) < std::tie(ot, ow, oa);
-}
-
-// Equality operator for unique
-auto Record::operator==(const Record& other) const -> bool
-{
-    auto t = time();
-    auto w = weather();
-    auto a = arrangement();
-
-    auto ot = other.time();
-    auto ow = other.weather();
-    auto oa = other.arrangement();
-
-    return std::tie(t, w, a) == std::tie(ot, ow, oa);
+    std::ostringstream oss;
+    oss << to_string(time) << " " << to_string(weather) << " " << (int)arrangement;
+    return oss.str();
 }
 
 auto to_string(ResourceType value) -> std::string
@@ -135,6 +93,45 @@ auto to_string(MapWeather value) -> std::string
     }
 }
 
+auto MapMeshData::num_bytes() const -> size_t
+{
+    return vertices.size_bytes() + indices.size_bytes() + chunks.size_bytes();
+}
+
+auto make_map_mesh_data(const FFTMesh& mesh, size_t first_vertex, size_t last_vertex, size_t first_index, size_t last_index) -> MapMeshData
+{
+    if (first_index == last_index) {
+        return {};
+    }
+
+    struct Storage {
+        std::vector<MapVertex> vertices;
+        std::vector<uint16_t> indices;
+        std::vector<MeshChunk> chunks;
+    };
+    auto storage = std::make_shared<Storage>();
+
+    std::span<const Vertex> vertices(mesh.vertices.data() + first_vertex, last_vertex - first_vertex);
+    storage->indices.assign(mesh.indices.begin() + first_index, mesh.indices.begin() + last_index);
+    for (auto& index : storage->indices) {
+        index -= first_vertex;
+    }
+
+    MapMeshData data = {};
+    std::tie(data.aabb, data.sphere) = compute_bounds(reinterpret_cast<const float*>(vertices.data()), vertices.size(), sizeof(Vertex) / sizeof(float));
+    storage->chunks = build_chunks(vertices, storage->indices, data.aabb);
+    storage->vertices.reserve(vertices.size());
+    for (const auto& vertex : vertices) {
+        storage->vertices.push_back(pack_map_vertex(vertex));
+    }
+
+    data.vertices = storage->vertices;
+    data.indices = storage->indices;
+    data.chunks = storage->chunks;
+    data.storage = std::move(storage);
+    return data;
+}
+
 std::map<int, FFTMapDesc> map_list = {
     { 0, { 0, 10026, "Unknown", false } }, // No texture
     { 1, { 1, 11304, "At Main Gate of Igros Castle", true } },
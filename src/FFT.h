@@ -3,19 +3,22 @@
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <map>
 #include <memory>
+#include <span>
 #include <string.h>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "Event.h"
-#include "Model.h"
-#include "Texture.h"
+#include "Geometry.h"
+#include "Terrain.h"
 
 #include "glm/glm.hpp"
 
@@ -25,9 +28,21 @@ constexpr size_t SECTOR_SIZE = 2048;
 constexpr size_t SECTOR_SIZE_RAW = 2352;
 constexpr size_t SECTOR_HEADER_SIZE = 24;
 constexpr size_t GNS_MAX_SIZE = 2388;
+constexpr size_t GNS_RECORD_SIZE = 20;
 constexpr size_t RECORD_MAX_NUM = 100;
 
-enum class ResourceType : int {
+// FFT Texture dimensions are always 256 * 256 * 4 pages (256*1024).
+constexpr int FFT_TEXTURE_WIDTH = 256;
+constexpr int FFT_TEXTURE_HEIGHT = 1024;
+constexpr int FFT_TEXTURE_NUM_PIXELS = (256 * 1024);                // 262144
+constexpr int FFT_TEXTURE_NUM_BYTES = (FFT_TEXTURE_NUM_PIXELS * 1); // Pixel * 1 byte per pixel (R8 palette index).
+constexpr int FFT_TEXTURE_RAW_SIZE = (FFT_TEXTURE_NUM_PIXELS / 2);  // Each pixel on disk 1/2 a byte.
+
+// FFT Palette dimensions are always 256 * 1.
+constexpr int FFT_PALETTE_NUM_PIXELS = (16 * 16);
+constexpr int FFT_PALETTE_NUM_BYTES = (FFT_PALETTE_NUM_PIXELS * 4);
+
+enum class ResourceType : uint16_t {
     Texture = 0x1701,
     MeshPrimary = 0x2E01,
     MeshOverride = 0x2F01,
@@ -35,12 +50,12 @@ enum class ResourceType : int {
     End = 0x3101,
 };
 
-enum class MapTime {
+enum class MapTime : uint8_t {
     Day = 0x0,
     Night = 0x1,
 };
 
-enum class MapWeather {
+enum class MapWeather : uint8_t {
     None = 0x0,
     NoneAlt = 0x1,
     Normal = 0x2,
@@ -52,33 +67,118 @@ auto to_string(ResourceType value) -> std::string;
 auto to_string(MapTime value) -> std::string;
 auto to_string(MapWeather value) -> std::string;
 
-// Record represents a GNS record.
+// GNSRecordLayout is the byte offset of each field in a raw GNS record.
+struct GNSRecordLayout {
+    static constexpr size_t arrangement = 2;
+    static constexpr size_t style = 3; // time: bit 7, weather: bits 4-6
+    static constexpr size_t resource_type = 4;
+    static constexpr size_t sector = 8;
+    static constexpr size_t length = 12;
+};
+static_assert(GNSRecordLayout::length + sizeof(uint32_t) <= GNS_RECORD_SIZE);
+
+// Record represents a GNS record, decoded once from its raw bytes.
+//
+// style_key packs time, weather and arrangement so that comparing keys orders
+// records by time, then weather, then arrangement. Sorting and de-duplicating
+// styles is a single integer compare.
 struct Record {
-    std::vector<uint8_t> data;
-
-    auto repr() -> std::string;
-    auto sector() -> int;
-    auto length() -> uint64_t;
-    auto resource_type() -> ResourceType;
-    auto arrangement() const -> int;
-    auto time() const -> MapTime;
-    auto weather() const -> MapWeather;
-
-    auto operator<(const Record& other) const -> bool;
-    auto operator==(const Record& other) const -> bool;
+    Record() = default;
+    explicit Record(std::span<const uint8_t> bytes);
+
+    uint32_t style_key = 0;
+    ResourceType resource_type = ResourceType::End;
+    uint16_t sector = 0;
+    uint32_t length = 0;
+    MapTime time = MapTime::Day;
+    MapWeather weather = MapWeather::None;
+    uint8_t arrangement = 0;
+    uint8_t padding = 0;
+
+    auto repr() const -> std::string;
+
+    // Records compare by style only.
+    auto operator<(const Record& other) const -> bool { return style_key < other.style_key; }
+    auto operator==(const Record& other) const -> bool { return style_key == other.style_key; }
+};
+static_assert(std::is_trivially_copyable_v<Record>);
+static_assert(sizeof(Record) == 16);
+static_assert(offsetof(Record, style_key) == 0 && offsetof(Record, length) == 8 && offsetof(Record, time) == 12);
+
+constexpr auto style_key(MapTime time, MapWeather weather, int arrangement) -> uint32_t
+{
+    return (static_cast<uint32_t>(time) << 16) | (static_cast<uint32_t>(weather) << 8) | static_cast<uint32_t>(arrangement & 0xFF);
+}
+
+// LightData is a directional light as stored in a mesh file.
+struct LightData {
+    glm::vec4 color = {};
+    glm::vec3 position = {};
+
+    auto is_valid() const -> bool { return color.x + color.y + color.z > 0.0f; }
 };
 
+// MapMeshData is one part of a map's geometry, the base or the alt mesh,
+// laid out exactly as it is uploaded: packed vertices, indices rebased to
+// the part's first vertex and sorted into chunks, the chunks and the bounds.
+// The spans point into `storage`, which is either arrays built by
+// make_map_mesh_data or a cooked file mapped read-only.
+struct MapMeshData {
+    std::span<const MapVertex> vertices = {};
+    std::span<const uint16_t> indices = {};
+    std::span<const MeshChunk> chunks = {};
+    AABB aabb = {};
+    BoundingSphere sphere = {};
+    std::shared_ptr<const void> storage = nullptr;
+
+    auto num_bytes() const -> size_t;
+};
+
+// FFTMesh and FFTMap are plain CPU-side data. They hold no GPU resources, so
+// they can be read, cached and cooked on any thread. The renderer creates the
+// meshes, textures and lights from them.
 struct FFTMesh {
+    // Indexed triangle list. Quads share their diagonal vertices.
     std::vector<Vertex> vertices;
-    std::shared_ptr<Texture> palette = nullptr;
-    std::vector<std::shared_ptr<Light>> lights;
+    std::vector<uint16_t> indices;
+
+    // Source polygon of each triangle. Polygons are numbered in mesh file
+    // order; merged meshes continue after the polygons before them.
+    std::vector<uint16_t> polygons;
+
+    // RGBA8, FFT_PALETTE_NUM_BYTES. Empty if the mesh file has no palette.
+    std::vector<uint8_t> palette = {};
+
+    std::vector<LightData> lights;
     glm::vec4 ambient_color = {};
     std::pair<glm::vec4, glm::vec4> background = {};
+
+    // Invalid if the mesh file has no terrain.
+    Terrain terrain = {};
+
+    // The first base_num_vertices and base_num_indices entries are the map's
+    // primary and override meshes, which every style shares. The rest is the
+    // style's alt mesh. Its indices only refer to its own vertices.
+    uint32_t base_num_vertices = 0;
+    uint32_t base_num_indices = 0;
+
+    auto has_alt_geometry() const -> bool { return indices.size() > base_num_indices; }
+
+    // The base and alt meshes ready for upload. Both are empty until
+    // read_map fills them.
+    MapMeshData base_data = {};
+    MapMeshData alt_data = {};
+
+    // Average cache miss ratio before and after the vertex cache pass.
+    float acmr_before = 0.0f;
+    float acmr_after = 0.0f;
 };
 
 struct FFTMap {
     std::shared_ptr<FFTMesh> mesh = nullptr;
-    std::shared_ptr<Texture> texture = nullptr;
+
+    // R8 palette indices, FFT_TEXTURE_NUM_BYTES. Empty if the map has no texture.
+    std::vector<uint8_t> texture = {};
 
     // GNS records that are useful to list in the UI
     std::vector<Record> gns_records = {};
@@ -94,3 +194,8 @@ struct FFTMapDesc {
 };
 
 extern std::map<int, FFTMapDesc> map_list;
+
+// make_map_mesh_data lays out the vertices in [first_vertex, last_vertex)
+// and the indices in [first_index, last_index) for upload. It returns empty
+// data if there are no indices.
+auto make_map_mesh_data(const FFTMesh& mesh, size_t first_vertex, size_t last_vertex, size_t first_index, size_t last_index) -> MapMeshData;
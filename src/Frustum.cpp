@@ -0,0 +1,45 @@
+#include "Frustum.h"
+
+// Planes are extracted from the rows of the matrix (Gribb and Hartmann).
+// They are left unnormalized since only the sign of the distance matters.
+Frustum::Frustum(const glm::mat4& view_proj)
+{
+    auto row = [&](int i) {
+        return glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]);
+    };
+
+    m_planes[0] = row(3) + row(0); // Left
+    m_planes[1] = row(3) - row(0); // Right
+    m_planes[2] = row(3) + row(1); // Bottom
+    m_planes[3] = row(3) - row(1); // Top
+    m_planes[4] = row(3) + row(2); // Near
+    m_planes[5] = row(3) - row(2); // Far
+}
+
+// classify tests the corners nearest and farthest along each plane normal.
+// A box is outside if its farthest corner is behind any plane, and inside
+// if its nearest corner is in front of all of them.
+auto Frustum::classify(const AABB& aabb) const -> Containment
+{
+    Containment result = Containment::Inside;
+    for (const auto& plane : m_planes) {
+        glm::vec3 far_corner = {
+            plane.x >= 0.0f ? aabb.max.x : aabb.min.x,
+            plane.y >= 0.0f ? aabb.max.y : aabb.min.y,
+            plane.z >= 0.0f ? aabb.max.z : aabb.min.z,
+        };
+        glm::vec3 near_corner = {
+            plane.x >= 0.0f ? aabb.min.x : aabb.max.x,
+            plane.y >= 0.0f ? aabb.min.y : aabb.max.y,
+            plane.z >= 0.0f ? aabb.min.z : aabb.max.z,
+        };
+
+        if (glm::dot(glm::vec3(plane), far_corner) + plane.w < 0.0f) {
+            return Containment::Outside;
+        }
+        if (glm::dot(glm::vec3(plane), near_corner) + plane.w < 0.0f) {
+            result = Containment::Intersects;
+        }
+    }
+    return result;
+}
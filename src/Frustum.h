@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+
+#include "Mesh.h"
+
+#include "glm/glm.hpp"
+
+enum class Containment {
+    Outside,
+    Intersects,
+    Inside,
+};
+
+// Frustum holds the six clip planes of a view projection matrix, facing
+// inward. The near plane uses the OpenGL depth range, which is a superset
+// of the zero-to-one range, so it never culls something visible.
+class Frustum {
+public:
+    explicit Frustum(const glm::mat4& view_proj);
+
+    auto classify(const AABB& aabb) const -> Containment;
+
+private:
+    std::array<glm::vec4, 6> m_planes = {};
+};
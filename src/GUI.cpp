@@ -7,6 +7,7 @@
 #include "GUI.h"
 #include "Model.h"
 #include "ResourceManager.h"
+#include "SIMD.h"
 #include "State.h"
 #include "utils.h"
 
@@ -155,27 +156,27 @@ auto GUI::draw_records() -> void
 
             // Column 0: ID
             ImGui::TableSetColumnIndex(0);
-            ImGui::Text("%d", record.sector());
+            ImGui::Text("%d", record.sector);
 
             // Column 1: Length
             ImGui::TableSetColumnIndex(1);
-            ImGui::Text("%llu", record.length());
+            ImGui::Text("%u", record.length);
 
             // Column 2: Type
             ImGui::TableSetColumnIndex(2);
-            ImGui::Text("%s", to_string(record.resource_type()).data());
+            ImGui::Text("%s", to_string(record.resource_type).data());
 
             // Column 3: Arrangement
             ImGui::TableSetColumnIndex(3);
-            ImGui::Text("%d", record.arrangement());
+            ImGui::Text("%d", record.arrangement);
 
             // Column 4: Time
             ImGui::TableSetColumnIndex(4);
-            ImGui::Text("%s", to_string(record.time()).data());
+            ImGui::Text("%s", to_string(record.time).data());
 
             // Column 5: Weather
             ImGui::TableSetColumnIndex(5);
-            ImGui::Text("%s", to_string(record.weather()).data());
+            ImGui::Text("%s", to_string(record.weather).data());
         }
 
         // End the table
@@ -213,7 +214,7 @@ auto GUI::draw() -> void
             state->scenarios.begin(),
             state->scenarios.end(),
             std::back_inserter(scenario_names),
-            [](Scenario& s) { return scenario_list[s.id()]; });
+            [](Scenario& s) { return scenario_list[s.id]; });
 
         std::vector<const char*> scenario_name_ptrs;
         scenario_name_ptrs.reserve(scenario_names.size());
@@ -226,9 +227,9 @@ auto GUI::draw() -> void
             state->set_scenario(new_scenario);
         }
 
-        ImGui::Text("Map: %s", map_list[state->current_scenario.map_id()].name.c_str());
-        ImGui::Text("Time: %s", to_string(state->current_scenario.time()).c_str());
-        ImGui::Text("Weather: %s", to_string(state->current_scenario.weather()).c_str());
+        ImGui::Text("Map: %s", map_list[state->current_scenario.map_id].name.c_str());
+        ImGui::Text("Time: %s", to_string(state->current_scenario.time).c_str());
+        ImGui::Text("Weather: %s", to_string(state->current_scenario.weather).c_str());
 
     } else if (scenarios_or_maps == 1) {
         std::vector<std::string> map_names;
@@ -272,10 +273,20 @@ auto GUI::draw() -> void
 
         if (ImGui::Combo("Style", &state->current_style_index, style_name_ptrs.data(), style_name_ptrs.size())) {
             auto record = records_copy[state->current_style_index];
-            state->set_map(state->current_map_index, record.time(), record.weather(), record.arrangement());
+            state->set_map(state->current_map_index, record.time, record.weather, record.arrangement);
         }
     }
 
+    if (state->map_loader.is_loading()) {
+        const char* spinner = "|/-\\";
+        ImGui::Text("%c Loading %s", spinner[(int)(ImGui::GetTime() * 8.0) % 4], state->map_loader.loading_key().repr().c_str());
+    }
+    ImGui::Text("Cached maps: %zu (%.1f / %.0f MiB)", state->map_cache.size(),
+        state->map_cache.num_bytes() / (1024.0 * 1024.0), state->map_cache.budget_bytes() / (1024.0 * 1024.0));
+    auto prefetch_stats = state->map_prefetcher.stats();
+    ImGui::Text("Prefetched: %zu (%.1f MiB), %llu hits, %llu misses", prefetch_stats.size, prefetch_stats.num_bytes / (1024.0 * 1024.0),
+        (unsigned long long)prefetch_stats.hits, (unsigned long long)prefetch_stats.misses);
+
     ImGui::Separator();
 
     if (ImGui::RadioButton("Perspective", state->orbital_camera.projection == Projection::Perspective)) {
@@ -299,6 +310,7 @@ auto GUI::draw() -> void
     ImGui::Separator();
     if (ImGui::CollapsingHeader("Rendering")) {
         ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+        ImGui::Text("SIMD: %s", simd_path());
         // Render Mode
         if (ImGui::RadioButton("Textured", state->renderer.render_mode == 0)) {
             state->renderer.render_mode = 0;
@@ -313,9 +325,48 @@ auto GUI::draw() -> void
         }
 
         ImGui::SliderFloat("Rotation", &state->scene.rotation_speed, 0.0f, 2.0f);
+
+        const auto& stats = state->scene.stats;
+        ImGui::Checkbox("Frustum Culling", &state->scene.use_culling);
+        ImGui::Text("Objects: %d drawn, %d culled", stats.drawn_objects, stats.culled_objects);
+        ImGui::Text("Chunks: %d drawn, %d culled", stats.drawn_chunks, stats.culled_chunks);
+        ImGui::Text("Triangles: %zu drawn, %zu culled", stats.drawn_triangles, stats.culled_triangles);
         // ImGui::ColorEdit3("Background", &state->renderer.clear_color.r);
     }
     ImGui::NewLine();
+    if (ImGui::CollapsingHeader("Picking")) {
+        if (state->current_map_bvh != nullptr) {
+            ImGui::Text("BVH: %zu nodes, %zu triangles", state->current_map_bvh->node_count(), state->current_map_bvh->triangle_count());
+        }
+        ImGui::Text("Query: %.1fus", state->pick_microseconds);
+        if (state->picked.has_value()) {
+            const auto& picked = *state->picked;
+            ImGui::Text("Triangle: %u", picked.triangle);
+            ImGui::Text("Polygon: %u", picked.polygon);
+            ImGui::Text("Position: %.1f, %.1f, %.1f", picked.position.x, picked.position.y, picked.position.z);
+        } else {
+            ImGui::Text("Nothing under the cursor");
+        }
+
+        if (state->current_map_mesh != nullptr && state->current_map_mesh->terrain.is_valid()) {
+            const auto& terrain = state->current_map_mesh->terrain;
+            ImGui::SeparatorText("Terrain");
+            ImGui::Text("Size: %d x %d", terrain.size_x, terrain.size_z);
+            ImGui::SliderInt("Move", &state->move_rules.move, 1, 10);
+            ImGui::SliderInt("Jump", &state->move_rules.jump, 1, 10);
+            if (state->picked_tile.has_value()) {
+                const auto& hit = *state->picked_tile;
+                const auto* tile = terrain.tile(hit.x, hit.z, hit.level);
+                ImGui::Text("Tile: %d, %d (level %d)", hit.x, hit.z, hit.level);
+                ImGui::Text("Height: %d, slope %d (type 0x%02X)", tile->height, tile->slope_height, tile->slope_type);
+                ImGui::Text("Surface: %d, depth %d, flags 0x%02X", tile->surface_type, tile->depth, tile->flags);
+                ImGui::Text("Reachable: %zu tiles", state->reachable_tiles);
+            } else {
+                ImGui::Text("No tile under the cursor");
+            }
+        }
+    }
+    ImGui::NewLine();
     if (ImGui::CollapsingHeader("Lighting")) {
         ImGui::Checkbox("Lighting Enabled", &state->scene.use_lighting);
         ImGui::SameLine();
@@ -346,6 +397,16 @@ auto GUI::draw() -> void
         }
     }
 
+    ImGui::NewLine();
+    if (ImGui::CollapsingHeader("Disc")) {
+        auto cache = resources->get_bin_reader()->cache_stats();
+        ImGui::Text("Sector cache: %zu / %zu sectors", cache.size, cache.capacity);
+        ImGui::Text("Hit rate: %.1f%%", cache.hit_rate() * 100.0);
+        ImGui::Text("Hits: %llu  Misses: %llu", (unsigned long long)cache.hits, (unsigned long long)cache.misses);
+        ImGui::Text("Evictions: %llu", (unsigned long long)cache.evictions);
+        ImGui::Text("Served: %.2f MiB", (double)cache.bytes_served / (1024.0 * 1024.0));
+    }
+
     ImGui::NewLine();
     ImGui::Separator();
 
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include "Geometry.h"
+#include "SIMD.h"
+
+auto AABB::center() const -> glm::vec3
+{
+    return (min + max) * 0.5f;
+}
+
+auto AABB::size() const -> glm::vec3
+{
+    return max - min;
+}
+
+// transformed moves the center and projects the extents onto the new axes
+// (Arvo), which is cheaper than transforming all eight corners.
+auto AABB::transformed(const glm::mat4& matrix) const -> AABB
+{
+    glm::vec3 extents = size() * 0.5f;
+    glm::vec3 moved_center = glm::vec3(matrix * glm::vec4(center(), 1.0f));
+    glm::vec3 moved_extents = {};
+    for (int i = 0; i < 3; i++) {
+        moved_extents[i] = std::abs(matrix[0][i]) * extents.x
+            + std::abs(matrix[1][i]) * extents.y
+            + std::abs(matrix[2][i]) * extents.z;
+    }
+    return { moved_center - moved_extents, moved_center + moved_extents };
+}
+
+// Positions and uvs come from integers so they round-trip exactly. Normals
+// keep 10 bits.
+auto pack_map_vertex(const Vertex& vertex) -> MapVertex
+{
+    auto quantize = [](float value, float scale, int max) {
+        return std::clamp((int)std::lround(value * scale), 0, max);
+    };
+
+    const auto& n = vertex.normal;
+    const auto& uv = vertex.tex_coords;
+
+    MapVertex out = {};
+    out.position[0] = (int16_t)std::lround(vertex.position.x);
+    out.position[1] = (int16_t)std::lround(vertex.position.y);
+    out.position[2] = (int16_t)std::lround(vertex.position.z);
+    if (vertex.textured) {
+        uint32_t x = quantize(n.x * 0.5f + 0.5f, 1023.0f, 1023);
+        uint32_t y = quantize(n.y * 0.5f + 0.5f, 1023.0f, 1023);
+        uint32_t z = quantize(n.z * 0.5f + 0.5f, 1023.0f, 1023);
+        // UINT10_N2 is normalized, so w = 3 reaches vs_map as 1.0.
+        out.normal = x | (y << 10) | (z << 20) | (3u << 30);
+
+        int v = quantize(uv.y, 1023.0f, 1023);
+        out.uv[0] = quantize(uv.x, 255.0f, 255);
+        out.uv[1] = v & 0xFF;
+        out.uv[2] = v >> 8;
+    }
+    out.uv[3] = (uint8_t)vertex.palette_index;
+    return out;
+}
+
+// Callers pass Vertex arrays, so positions must come first.
+static_assert(offsetof(Vertex, position) == 0);
+
+auto compute_bounds(const float* positions, size_t count, size_t stride) -> std::pair<AABB, BoundingSphere>
+{
+    if (count == 0) {
+        return {};
+    }
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    minmax_xyz(positions, count, stride, &min.x, &max.x);
+    AABB aabb = { min, max };
+
+    float radius_squared = 0.0f;
+    glm::vec3 center = aabb.center();
+    for (size_t i = 0; i < count; i++) {
+        const float* p = positions + i * stride;
+        glm::vec3 offset = glm::vec3(p[0], p[1], p[2]) - center;
+        radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+    }
+    return { aabb, { center, std::sqrt(radius_squared) } };
+}
+
+// build_chunks sorts triangles into a grid of MESH_CHUNK_SIZE cells on the
+// XZ plane by their centroid. The sort is stable so the vertex cache order
+// within each cell is kept. The grid is capped at MAX_CHUNK_CELLS per side
+// for very large meshes.
+auto build_chunks(std::span<const Vertex> vertices, std::vector<uint16_t>& indices, const AABB& aabb) -> std::vector<MeshChunk>
+{
+    constexpr int MAX_CHUNK_CELLS = 16;
+
+    std::vector<MeshChunk> chunks;
+    size_t num_triangles = indices.size() / 3;
+    if (num_triangles == 0) {
+        return chunks;
+    }
+
+    glm::vec3 size = aabb.size();
+    float cell_size = std::max({ MESH_CHUNK_SIZE, size.x / MAX_CHUNK_CELLS, size.z / MAX_CHUNK_CELLS });
+    int cells_x = std::max(1, (int)std::ceil(size.x / cell_size));
+    int cells_z = std::max(1, (int)std::ceil(size.z / cell_size));
+
+    std::vector<uint32_t> cell_of(num_triangles);
+    std::vector<uint32_t> offsets(cells_x * cells_z + 1, 0);
+    for (size_t t = 0; t < num_triangles; t++) {
+        const auto& a = vertices[indices[t * 3 + 0]].position;
+        const auto& b = vertices[indices[t * 3 + 1]].position;
+        const auto& c = vertices[indices[t * 3 + 2]].position;
+        float x = (a.x + b.x + c.x) / 3.0f - aabb.min.x;
+        float z = (a.z + b.z + c.z) / 3.0f - aabb.min.z;
+        int cx = std::clamp((int)(x / cell_size), 0, cells_x - 1);
+        int cz = std::clamp((int)(z / cell_size), 0, cells_z - 1);
+        cell_of[t] = cz * cells_x + cx;
+        offsets[cell_of[t] + 1]++;
+    }
+    for (size_t i = 1; i < offsets.size(); i++) {
+        offsets[i] += offsets[i - 1];
+    }
+
+    std::vector<uint16_t> sorted(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < num_triangles; t++) {
+        uint32_t slot = fill[cell_of[t]]++;
+        std::copy_n(indices.begin() + t * 3, 3, sorted.begin() + slot * 3);
+    }
+    indices = std::move(sorted);
+
+    for (size_t cell = 0; cell + 1 < offsets.size(); cell++) {
+        if (offsets[cell] == offsets[cell + 1]) {
+            continue;
+        }
+        MeshChunk chunk = {};
+        chunk.first_index = offsets[cell] * 3;
+        chunk.num_indices = (offsets[cell + 1] - offsets[cell]) * 3;
+        chunk.aabb.min = glm::vec3(std::numeric_limits<float>::max());
+        chunk.aabb.max = glm::vec3(std::numeric_limits<float>::lowest());
+        for (uint32_t i = chunk.first_index; i < chunk.first_index + chunk.num_indices; i++) {
+            chunk.aabb.min = glm::min(chunk.aabb.min, vertices[indices[i]].position);
+            chunk.aabb.max = glm::max(chunk.aabb.max, vertices[indices[i]].position);
+        }
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
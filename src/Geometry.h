@@ -0,0 +1,83 @@
+#pragma once
+
+// Geometry types shared by the disc parsers and the renderer. Nothing here
+// depends on the GPU, so parsing code can use it on any thread.
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+struct Vertex {
+    glm::vec3 position = {};
+    glm::vec3 normal = {};
+    glm::vec2 tex_coords = {};
+    float palette_index = {};
+
+    // 1 for map vertices of textured polygons, the only ones with a normal
+    // and uv. A zero normal or uv doesn't tell them apart.
+    uint32_t textured = 0;
+};
+
+// AABB is an axis aligned bounding box in model space.
+struct AABB {
+    glm::vec3 min = {};
+    glm::vec3 max = {};
+
+    auto center() const -> glm::vec3;
+    auto size() const -> glm::vec3;
+
+    // transformed returns the box that encloses this one after `matrix`.
+    auto transformed(const glm::mat4& matrix) const -> AABB;
+};
+
+// BoundingSphere is centered on the AABB and reaches the farthest vertex.
+struct BoundingSphere {
+    glm::vec3 center = {};
+    float radius = 0.0f;
+};
+
+struct Ray {
+    glm::vec3 origin = {};
+    glm::vec3 direction = {};
+};
+
+// MapVertex is the packed GPU layout of map meshes, decoded by vs_map.
+//
+// - position: the original int16 coordinates (SHORT4, w unused).
+// - normal: xyz mapped from -1..1 to 0..1023, w is 3 for textured vertices
+//   and 0 otherwise (UINT10_N2, so 1.0 and 0.0 in vs_map). Untextured
+//   vertices have no normal or uv.
+// - uv: u, v within the page, page and palette (UBYTE4).
+struct MapVertex {
+    int16_t position[4];
+    uint32_t normal;
+    uint8_t uv[4];
+};
+static_assert(sizeof(MapVertex) == 16);
+
+// pack_map_vertex reverses the decode in MeshFile::read_vertices.
+auto pack_map_vertex(const Vertex& vertex) -> MapVertex;
+
+// MeshChunk is a run of indices whose triangles share a cell of the chunk
+// grid, so parts of a large mesh can be culled on their own.
+struct MeshChunk {
+    uint32_t first_index = 0;
+    uint32_t num_indices = 0;
+    AABB aabb = {};
+};
+
+// MESH_CHUNK_SIZE is the width of a chunk grid cell on the ground (XZ)
+// plane. Map tiles are 28 units, so a cell is 4x4 tiles.
+constexpr float MESH_CHUNK_SIZE = 112.0f;
+
+// compute_bounds returns the box and sphere around `count` positions spaced
+// `stride` floats apart. Both are empty without positions.
+auto compute_bounds(const float* positions, size_t count, size_t stride) -> std::pair<AABB, BoundingSphere>;
+
+// build_chunks sorts the triangles in `indices` into chunks and returns the
+// chunks, which cover `indices` in order. `aabb` bounds `vertices`.
+auto build_chunks(std::span<const Vertex> vertices, std::vector<uint16_t>& indices, const AABB& aabb) -> std::vector<MeshChunk>;
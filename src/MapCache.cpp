@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <optional>
+
+#include "MapCache.h"
+#include "FFT.h"
+#include "ResourceManager.h"
+#include "Texture.h"
+
+// make_map_mesh uploads part of a map's geometry, or returns nullptr if it
+// has no triangles.
+static auto make_map_mesh(const MapMeshData& data) -> std::shared_ptr<Mesh>
+{
+    if (data.indices.empty()) {
+        return nullptr;
+    }
+    return std::make_shared<Mesh>(data);
+}
+
+GPUMap::GPUMap(const LoadedMap& _loaded, std::shared_ptr<Mesh> _base_mesh)
+    : loaded(_loaded)
+{
+    auto resources = ResourceManager::get_instance();
+    const auto& map = loaded.map;
+    const auto& fft_mesh = *map->mesh;
+
+    base_mesh = _base_mesh != nullptr ? _base_mesh : make_map_mesh(fft_mesh.base_data);
+    alt_mesh = make_map_mesh(fft_mesh.alt_data);
+
+    std::shared_ptr<Texture> texture = nullptr;
+    if (!map->texture.empty()) {
+        texture = std::make_shared<Texture>(map->texture.data(), FFT_TEXTURE_WIDTH, FFT_TEXTURE_HEIGHT, SG_PIXELFORMAT_R8);
+    }
+    std::shared_ptr<Texture> palette = nullptr;
+    if (!fft_mesh.palette.empty()) {
+        palette = std::make_shared<Texture>(fft_mesh.palette.data(), FFT_PALETTE_NUM_PIXELS, 1);
+    }
+    background = std::make_shared<Background>(fft_mesh.background);
+
+    // Both parts move by the center of the whole map.
+    std::optional<AABB> bounds = std::nullopt;
+    for (const auto& mesh : { base_mesh, alt_mesh }) {
+        if (mesh == nullptr) {
+            continue;
+        }
+        models.push_back(std::make_shared<PalettedModel>(mesh, texture, palette));
+        bounds = bounds.has_value() ? AABB { glm::min(bounds->min, mesh->aabb.min), glm::max(bounds->max, mesh->aabb.max) } : mesh->aabb;
+    }
+    glm::vec3 center_translation = bounds.has_value() ? -bounds->center() : glm::vec3(0.0f);
+    for (auto& model : models) {
+        model->translation = center_translation;
+    }
+
+    // Lights get the same translation as the map. We don't take the lights
+    // position into the center_translation calculation because they are so
+    // far away.
+    auto cube_mesh = resources->get_mesh("cube");
+    for (const auto& light_data : fft_mesh.lights) {
+        lights.push_back(std::make_shared<Light>(cube_mesh, light_data.color, light_data.position + center_translation));
+    }
+
+    // The decoded map, the alt mesh, texture and palette. The base mesh, its
+    // data and the BVH are counted by MapCache.
+    num_bytes = loaded.num_bytes();
+    if (alt_mesh != nullptr) {
+        num_bytes += mesh_num_bytes(*alt_mesh);
+    }
+    num_bytes += map->texture.size() + fft_mesh.palette.size();
+}
+
+// A map Mesh keeps no CPU copy, so it only holds its GPU buffers.
+auto mesh_num_bytes(const Mesh& mesh) -> size_t
+{
+    return mesh.num_vertices * sizeof(MapVertex) + mesh.num_indices * sizeof(uint16_t);
+}
+
+MapCache::MapCache(size_t budget_bytes)
+    : m_budget_bytes(budget_bytes)
+{
+}
+
+auto MapCache::get(const MapKey& key) -> std::shared_ptr<GPUMap>
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); it++) {
+        if ((*it)->loaded.key == key) {
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            return m_entries.front();
+        }
+    }
+    return nullptr;
+}
+
+auto MapCache::contains(const MapKey& key) const -> bool
+{
+    return std::any_of(m_entries.begin(), m_entries.end(), [&](const auto& entry) { return entry->loaded.key == key; });
+}
+
+auto MapCache::upload(const LoadedMap& loaded) -> std::shared_ptr<GPUMap>
+{
+    const auto& fft_mesh = *loaded.map->mesh;
+    std::shared_ptr<Mesh> base_mesh = nullptr;
+    for (const auto& base : m_bases) {
+        if (base.map_num == loaded.key.map_num
+            && base.mesh->num_vertices == fft_mesh.base_num_vertices
+            && base.mesh->num_indices == fft_mesh.base_num_indices) {
+            base_mesh = base.mesh;
+            break;
+        }
+    }
+
+    auto map = std::make_shared<GPUMap>(loaded, base_mesh);
+    put(map);
+    return map;
+}
+
+auto MapCache::put(std::shared_ptr<GPUMap> map) -> void
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); it++) {
+        if ((*it)->loaded.key == map->loaded.key) {
+            m_num_bytes -= (*it)->num_bytes + m_shared.remove((*it)->loaded);
+            release_base(**it);
+            m_entries.erase(it);
+            break;
+        }
+    }
+    m_num_bytes += map->num_bytes + m_shared.add(map->loaded);
+    acquire_base(*map);
+    m_entries.push_front(std::move(map));
+    evict();
+}
+
+auto MapCache::set_budget(size_t budget_bytes) -> void
+{
+    m_budget_bytes = budget_bytes;
+    evict();
+}
+
+auto MapCache::clear() -> void
+{
+    m_entries.clear();
+    m_bases.clear();
+    m_shared.clear();
+    m_num_bytes = 0;
+}
+
+// Evicted maps free their sokol buffers and images as soon as nothing else
+// holds them. The scene may still be drawing one until the next map is shown.
+auto MapCache::evict() -> void
+{
+    while (m_num_bytes > m_budget_bytes && m_entries.size() > 1) {
+        m_num_bytes -= m_entries.back()->num_bytes + m_shared.remove(m_entries.back()->loaded);
+        release_base(*m_entries.back());
+        m_entries.pop_back();
+    }
+}
+
+auto MapCache::acquire_base(const GPUMap& map) -> void
+{
+    if (map.base_mesh == nullptr) {
+        return;
+    }
+    auto it = std::find_if(m_bases.begin(), m_bases.end(), [&](const SharedBase& base) { return base.mesh == map.base_mesh; });
+    if (it == m_bases.end()) {
+        SharedBase base = { map.loaded.key.map_num, map.base_mesh, mesh_num_bytes(*map.base_mesh), 0 };
+        m_num_bytes += base.num_bytes;
+        it = m_bases.insert(m_bases.end(), base);
+    }
+    it->num_users++;
+}
+
+auto MapCache::release_base(const GPUMap& map) -> void
+{
+    auto it = std::find_if(m_bases.begin(), m_bases.end(), [&](const SharedBase& base) { return base.mesh == map.base_mesh; });
+    if (it == m_bases.end()) {
+        return;
+    }
+    it->num_users--;
+    if (it->num_users == 0) {
+        m_num_bytes -= it->num_bytes;
+        m_bases.erase(it);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "MapLoader.h"
+#include "Mesh.h"
+#include "Model.h"
+
+// Maps stay cached until the total passes this many bytes.
+constexpr size_t MAP_CACHE_BUDGET_BYTES = 256 * 1024 * 1024;
+
+// GPUMap is a map ready to render: the decoded map and the GPU objects made
+// from it. Its buffers and images are released when the last reference is
+// dropped.
+//
+// The geometry is split in two meshes. base_mesh is the primary and override
+// meshes, which are the same for every style, so it is shared by all cached
+// styles of the map. alt_mesh is the style's own geometry. Either is nullptr
+// if it has no triangles, and there is one model per mesh.
+struct GPUMap {
+    // `base_mesh` is an existing upload of the map's base to reuse, or
+    // nullptr to upload it.
+    GPUMap(const LoadedMap& loaded, std::shared_ptr<Mesh> base_mesh);
+
+    LoadedMap loaded = {};
+    std::shared_ptr<Mesh> base_mesh = nullptr;
+    std::shared_ptr<Mesh> alt_mesh = nullptr;
+    std::vector<std::shared_ptr<PalettedModel>> models = {};
+    std::shared_ptr<Background> background = nullptr;
+    std::vector<std::shared_ptr<Light>> lights = {};
+
+    // Approximate CPU and GPU memory held by this map, without base_mesh and
+    // what LoadedMap::num_bytes leaves out. MapCache counts each of those
+    // once, however many styles share it.
+    size_t num_bytes = 0;
+};
+
+// mesh_num_bytes is the GPU memory of a map Mesh.
+auto mesh_num_bytes(const Mesh& mesh) -> size_t;
+
+// MapCache keeps the most recently shown maps so going back to one doesn't
+// read, decode or upload it again. There are only a few dozen entries at
+// most, so lookups walk the list.
+class MapCache {
+public:
+    explicit MapCache(size_t budget_bytes = MAP_CACHE_BUDGET_BYTES);
+
+    // get returns the cached map and marks it most recently used.
+    auto get(const MapKey& key) -> std::shared_ptr<GPUMap>;
+
+    // contains is true if the map is cached. It doesn't change the order.
+    auto contains(const MapKey& key) const -> bool;
+
+    // upload makes the GPU objects for a loaded map, reusing the base mesh
+    // of another style of the same map if one is still alive, and puts it.
+    auto upload(const LoadedMap& loaded) -> std::shared_ptr<GPUMap>;
+
+    // put adds a map as most recently used and evicts the least recently
+    // used maps until the cache fits its budget. The newest map is always
+    // kept, even if it's larger than the budget on its own.
+    auto put(std::shared_ptr<GPUMap> map) -> void;
+
+    auto set_budget(size_t budget_bytes) -> void;
+    auto clear() -> void;
+
+    auto size() const -> size_t { return m_entries.size(); }
+    auto num_bytes() const -> size_t { return m_num_bytes; }
+    auto budget_bytes() const -> size_t { return m_budget_bytes; }
+
+private:
+    // SharedBase is a base mesh used by cached styles of one map.
+    struct SharedBase {
+        int map_num = 0;
+        std::shared_ptr<Mesh> mesh = nullptr;
+        size_t num_bytes = 0;
+        size_t num_users = 0;
+    };
+
+    auto evict() -> void;
+    auto acquire_base(const GPUMap& map) -> void;
+    auto release_base(const GPUMap& map) -> void;
+
+    std::list<std::shared_ptr<GPUMap>> m_entries = {}; // Most recently used first
+
+    // A base mesh's bytes are counted from the first cached style that uses
+    // it until the last one is evicted. Then it's dropped here too.
+    std::vector<SharedBase> m_bases = {};
+    SharedBytes m_shared = {};
+    size_t m_num_bytes = 0;
+    size_t m_budget_bytes = 0;
+};
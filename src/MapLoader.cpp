@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "BinReader.h"
+#include "MapLoader.h"
+#include "MapPrefetcher.h"
+#include "ResourceManager.h"
+
+MapLoader::MapLoader(MapPrefetcher* prefetcher)
+    : m_prefetcher(prefetcher)
+    , m_thread(&MapLoader::run, this)
+{
+}
+
+MapLoader::~MapLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    if (m_prefetcher != nullptr) {
+        m_prefetcher->interrupt();
+    }
+    m_thread.join();
+}
+
+auto MapLoader::request(const MapKey& key) -> void
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation++;
+        m_pending = key;
+        m_newest = key;
+        m_ready = std::nullopt;
+        m_loading = true;
+    }
+    m_wake.notify_one();
+    if (m_prefetcher != nullptr) {
+        m_prefetcher->interrupt();
+    }
+}
+
+auto MapLoader::cancel() -> void
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation++;
+        m_pending = std::nullopt;
+        m_ready = std::nullopt;
+        m_loading = false;
+    }
+    if (m_prefetcher != nullptr) {
+        m_prefetcher->interrupt();
+    }
+}
+
+auto MapLoader::poll() -> std::optional<LoadedMap>
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_ready.has_value()) {
+        return std::nullopt;
+    }
+    auto loaded = std::move(m_ready);
+    m_ready = std::nullopt;
+    m_loading = false;
+    return loaded;
+}
+
+auto MapLoader::is_loading() const -> bool
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_loading;
+}
+
+auto MapLoader::loading_key() const -> MapKey
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_newest;
+}
+
+// is_current is false once a request is superseded or the loader is
+// stopping.
+auto MapLoader::is_current(uint64_t generation) const -> bool
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_stop && generation == m_generation;
+}
+
+auto MapLoader::run() -> void
+{
+    while (true) {
+        MapKey key = { 0 };
+        uint64_t generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_pending.has_value(); });
+            if (m_stop) {
+                return;
+            }
+            key = *m_pending;
+            generation = m_generation;
+            m_pending = std::nullopt;
+        }
+
+        auto loaded = load(key, generation);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (loaded.has_value() && generation == m_generation) {
+            m_ready = std::move(loaded);
+        }
+    }
+}
+
+// has_same_triangles is true for two styles of a map that only differ in
+// palette, lights or texture.
+static auto has_same_triangles(const ReusableBVH& previous, const LoadedMap& loaded) -> bool
+{
+    if (previous.bvh == nullptr || loaded.map == nullptr || previous.map_num != loaded.key.map_num) {
+        return false;
+    }
+    const auto& mesh = *loaded.map->mesh;
+    return !mesh.has_alt_geometry()
+        && previous.base_num_vertices == mesh.base_num_vertices
+        && previous.base_num_indices == mesh.base_num_indices;
+}
+
+auto LoadedMap::num_bytes() const -> size_t
+{
+    if (map == nullptr) {
+        return 0;
+    }
+    // FFTMesh holds its Terrain by value.
+    size_t bytes = sizeof(FFTMesh) + sizeof(FFTMap);
+    bytes += map->mesh->vertices.size() * sizeof(Vertex);
+    bytes += map->mesh->alt_data.num_bytes();
+    bytes += (map->mesh->indices.size() + map->mesh->polygons.size()) * sizeof(uint16_t);
+    bytes += map->mesh->palette.size() + map->texture.size();
+    bytes += map->gns_records.size() * sizeof(Record);
+    if (pathfinder != nullptr) {
+        bytes += sizeof(Pathfinder);
+    }
+    return bytes;
+}
+
+auto LoadedMap::reusable_bvh() const -> ReusableBVH
+{
+    if (map == nullptr || map->mesh->has_alt_geometry()) {
+        return {};
+    }
+    return { key.map_num, map->mesh->base_num_vertices, map->mesh->base_num_indices, bvh };
+}
+
+auto SharedBytes::add(const void* resource, size_t num_bytes) -> size_t
+{
+    if (resource == nullptr) {
+        return 0;
+    }
+    auto it = std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry& entry) { return entry.resource == resource; });
+    if (it != m_entries.end()) {
+        it->num_users++;
+        return 0;
+    }
+    m_entries.push_back({ resource, num_bytes, 1 });
+    return num_bytes;
+}
+
+auto SharedBytes::add(const LoadedMap& loaded) -> size_t
+{
+    size_t bytes = 0;
+    if (loaded.bvh != nullptr) {
+        bytes += add(loaded.bvh.get(), loaded.bvh->num_bytes());
+    }
+    if (loaded.map != nullptr) {
+        const auto& base_data = loaded.map->mesh->base_data;
+        bytes += add(base_data.storage.get(), base_data.num_bytes());
+    }
+    return bytes;
+}
+
+auto SharedBytes::remove(const LoadedMap& loaded) -> size_t
+{
+    size_t bytes = remove(loaded.bvh.get());
+    if (loaded.map != nullptr) {
+        bytes += remove(loaded.map->mesh->base_data.storage.get());
+    }
+    return bytes;
+}
+
+auto SharedBytes::remove(const void* resource) -> size_t
+{
+    auto it = std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry& entry) { return entry.resource == resource; });
+    if (it == m_entries.end()) {
+        return 0;
+    }
+    it->num_users--;
+    if (it->num_users > 0) {
+        return 0;
+    }
+    size_t num_bytes = it->num_bytes;
+    m_entries.erase(it);
+    return num_bytes;
+}
+
+auto load_map(const MapKey& key, const ReusableBVH* previous, const std::function<bool()>& is_cancelled) -> std::optional<LoadedMap>
+{
+    auto start = std::chrono::steady_clock::now();
+    auto resources = ResourceManager::get_instance();
+    auto reader = resources->get_bin_reader();
+    auto cooked_cache = resources->get_cooked_cache();
+
+    LoadedMap loaded = {};
+    loaded.key = key;
+    if (cooked_cache != nullptr) {
+        loaded.map = cooked_cache->load_or_cook(*reader, key);
+    } else {
+        loaded.map = reader->read_map(key.map_num, key.time, key.weather, key.arrangement);
+    }
+    if (is_cancelled && is_cancelled()) {
+        return std::nullopt;
+    }
+
+    if (loaded.map != nullptr) {
+        if (previous != nullptr && has_same_triangles(*previous, loaded)) {
+            loaded.bvh = previous->bvh;
+        } else {
+            loaded.bvh = std::make_shared<BVH>(loaded.map->mesh->vertices, loaded.map->mesh->indices);
+        }
+        if (loaded.map->mesh->terrain.is_valid()) {
+            loaded.pathfinder = std::make_shared<Pathfinder>(loaded.map->mesh->terrain);
+        }
+    }
+
+    loaded.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return loaded;
+}
+
+// load checks between stages whether the request has been superseded, so
+// scrolling through maps doesn't queue up work for maps nobody will see.
+auto MapLoader::load(const MapKey& key, uint64_t generation) -> std::optional<LoadedMap>
+{
+    auto is_cancelled = [&] { return !is_current(generation); };
+    if (m_prefetcher != nullptr) {
+        auto prefetched = m_prefetcher->take(key, true, is_cancelled);
+        if (prefetched.has_value()) {
+            if (is_cancelled()) {
+                m_prefetcher->put(std::move(*prefetched));
+                return std::nullopt;
+            }
+            m_previous = prefetched->reusable_bvh();
+            return prefetched;
+        }
+        if (is_cancelled()) {
+            return std::nullopt;
+        }
+    }
+
+    auto loaded = load_map(key, &m_previous, is_cancelled);
+    if (loaded.has_value()) {
+        m_previous = loaded->reusable_bvh();
+    }
+    return loaded;
+}
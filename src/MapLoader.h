@@ -0,0 +1,132 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "BVH.h"
+#include "CookedCache.h"
+#include "FFT.h"
+#include "Pathfinder.h"
+
+struct ReusableBVH;
+
+// LoadedMap is the part of loading a map that needs no GPU: the decoded
+// map and the structures built from it.
+struct LoadedMap {
+    MapKey key = { 0 };
+    std::shared_ptr<FFTMap> map = nullptr; // nullptr if loading failed
+    std::shared_ptr<BVH> bvh = nullptr;
+    std::shared_ptr<Pathfinder> pathfinder = nullptr;
+    double milliseconds = 0.0;
+
+    // num_bytes is the approximate CPU memory held by the map and the
+    // structures built from it, without the BVH and the base mesh data.
+    // Styles of a map can share those, so caches count them once with
+    // SharedBytes.
+    auto num_bytes() const -> size_t;
+
+    auto reusable_bvh() const -> ReusableBVH;
+};
+
+// ReusableBVH keeps a loaded map's BVH and just enough of the map to tell
+// whether another style has the same triangles, without keeping the map
+// itself alive. Maps with alt geometry have no reusable BVH.
+struct ReusableBVH {
+    int map_num = -1;
+    size_t base_num_vertices = 0;
+    size_t base_num_indices = 0;
+    std::shared_ptr<BVH> bvh = nullptr;
+};
+
+// SharedBytes counts memory that entries of a cache share, e.g. a BVH, once
+// while any entry uses it. Resources are identified by address, so they must
+// stay alive while they have users.
+class SharedBytes {
+public:
+    // add and remove with a LoadedMap count the parts it can share with other
+    // styles: the BVH and the base mesh data.
+    auto add(const LoadedMap& loaded) -> size_t;
+    auto remove(const LoadedMap& loaded) -> size_t;
+
+    // add counts a user of `resource` and returns the bytes to add to the
+    // cache's total: `num_bytes` for its first user, otherwise 0.
+    auto add(const void* resource, size_t num_bytes) -> size_t;
+
+    // remove drops a user of `resource` and returns the bytes to subtract
+    // from the cache's total: all of its bytes once the last user is gone,
+    // otherwise 0.
+    auto remove(const void* resource) -> size_t;
+
+    auto clear() -> void { m_entries.clear(); }
+
+private:
+    struct Entry {
+        const void* resource = nullptr;
+        size_t num_bytes = 0;
+        size_t num_users = 0;
+    };
+    std::vector<Entry> m_entries = {};
+};
+
+// load_map reads or cooks a map and builds its BVH and pathfinder. It can run
+// on any thread. `previous` is the BVH of a map loaded before, reused if the
+// new map has the same triangles. Loading stops early and returns nothing
+// once `is_cancelled` returns true.
+auto load_map(const MapKey& key, const ReusableBVH* previous = nullptr, const std::function<bool()>& is_cancelled = nullptr) -> std::optional<LoadedMap>;
+
+class MapPrefetcher;
+
+// MapLoader loads maps on a worker thread so the UI keeps running. Only the
+// newest request matters: a request replaces any that hasn't started yet,
+// and the result of one that was superseded while loading is dropped.
+//
+// The main thread requests a map, then polls each frame and does the GPU
+// upload itself once the map is ready. Maps the prefetcher already has, or is
+// still loading, are taken from it instead of being loaded again.
+class MapLoader {
+public:
+    explicit MapLoader(MapPrefetcher* prefetcher = nullptr);
+    ~MapLoader();
+    MapLoader(const MapLoader&) = delete;
+    MapLoader& operator=(const MapLoader&) = delete;
+
+    auto request(const MapKey& key) -> void;
+
+    // cancel drops the pending request and the result of one in flight.
+    auto cancel() -> void;
+
+    // poll returns the newest requested map once it has loaded.
+    auto poll() -> std::optional<LoadedMap>;
+
+    // is_loading is true from a request until its map is polled.
+    auto is_loading() const -> bool;
+    auto loading_key() const -> MapKey;
+
+private:
+    auto run() -> void;
+    auto load(const MapKey& key, uint64_t generation) -> std::optional<LoadedMap>;
+    auto is_current(uint64_t generation) const -> bool;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::optional<MapKey> m_pending = std::nullopt;
+    std::optional<LoadedMap> m_ready = std::nullopt;
+    MapKey m_newest = { 0 };
+    uint64_t m_generation = 0;
+    bool m_loading = false;
+    bool m_stop = false;
+    MapPrefetcher* m_prefetcher = nullptr;
+
+    // The BVH of the worker's last loaded map, so styles with the same
+    // triangles can share it. Only touched by the worker.
+    ReusableBVH m_previous = {};
+
+    // Declared last so the thread starts after everything it uses.
+    std::thread m_thread;
+};
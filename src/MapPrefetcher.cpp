@@ -0,0 +1,154 @@
+#include <algorithm>
+
+#include "MapPrefetcher.h"
+
+MapPrefetcher::MapPrefetcher(size_t num_workers, size_t budget_bytes)
+    : m_budget_bytes(budget_bytes)
+{
+    for (size_t i = 0; i < num_workers; i++) {
+        m_threads.emplace_back(&MapPrefetcher::run, this);
+    }
+}
+
+MapPrefetcher::~MapPrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+auto MapPrefetcher::prefetch(std::vector<MapKey> keys) -> void
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.clear();
+        for (const auto& key : keys) {
+            if (!is_known(key)) {
+                m_queue.push_back(key);
+            }
+        }
+    }
+    m_wake.notify_all();
+}
+
+auto MapPrefetcher::take(const MapKey& key, bool wait, const std::function<bool()>& is_cancelled) -> std::optional<LoadedMap>
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto is_in_flight = [&] { return std::find(m_in_flight.begin(), m_in_flight.end(), key) != m_in_flight.end(); };
+    if (wait) {
+        m_done.wait(lock, [&] { return !is_in_flight() || (is_cancelled && is_cancelled()); });
+        if (is_in_flight()) {
+            return std::nullopt;
+        }
+    }
+
+    // The caller loads it now, so a worker shouldn't as well.
+    auto queued = std::find(m_queue.begin(), m_queue.end(), key);
+    if (queued != m_queue.end()) {
+        m_queue.erase(queued);
+    }
+
+    auto it = std::find_if(m_maps.begin(), m_maps.end(), [&](const LoadedMap& loaded) { return loaded.key == key; });
+    if (it == m_maps.end()) {
+        m_stats.misses++;
+        return std::nullopt;
+    }
+    m_stats.hits++;
+    m_stats.num_bytes -= it->num_bytes() + m_shared.remove(*it);
+    m_stats.size--;
+    auto loaded = std::move(*it);
+    m_maps.erase(it);
+    return loaded;
+}
+
+// interrupt takes the lock so a caller can't miss the wakeup between
+// checking `is_cancelled` and blocking.
+auto MapPrefetcher::interrupt() -> void
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_done.notify_all();
+}
+
+auto MapPrefetcher::put(LoadedMap loaded) -> void
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    insert(std::move(loaded));
+}
+
+auto MapPrefetcher::stats() const -> PrefetchStats
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+// is_known is true if the map is cached or being loaded. Callers hold the
+// lock.
+auto MapPrefetcher::is_known(const MapKey& key) const -> bool
+{
+    if (std::find(m_in_flight.begin(), m_in_flight.end(), key) != m_in_flight.end()) {
+        return true;
+    }
+    return std::any_of(m_maps.begin(), m_maps.end(), [&](const LoadedMap& loaded) { return loaded.key == key; });
+}
+
+// insert adds a map and evicts the least recently used ones over the
+// budget, but never the new one. Callers hold the lock.
+auto MapPrefetcher::insert(LoadedMap loaded) -> void
+{
+    if (is_known(loaded.key)) {
+        return;
+    }
+    m_stats.num_bytes += loaded.num_bytes() + m_shared.add(loaded);
+    m_stats.size++;
+    m_maps.push_front(std::move(loaded));
+    while (m_stats.num_bytes > m_budget_bytes && m_maps.size() > 1) {
+        m_stats.num_bytes -= m_maps.back().num_bytes() + m_shared.remove(m_maps.back());
+        m_stats.size--;
+        m_stats.evictions++;
+        m_maps.pop_back();
+    }
+}
+
+auto MapPrefetcher::run() -> void
+{
+    // Each worker reuses the BVH of the last map it loaded when the next one
+    // is another style with the same triangles.
+    ReusableBVH previous = {};
+
+    while (true) {
+        MapKey key = { 0 };
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+            if (m_stop) {
+                return;
+            }
+            key = m_queue.front();
+            m_queue.pop_front();
+            if (is_known(key)) {
+                continue;
+            }
+            m_in_flight.push_back(key);
+        }
+
+        auto loaded = load_map(key, &previous);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_in_flight.erase(std::find(m_in_flight.begin(), m_in_flight.end(), key));
+            if (loaded.has_value() && loaded->map != nullptr) {
+                previous = loaded->reusable_bvh();
+                m_stats.loaded++;
+                insert(std::move(*loaded));
+            }
+        }
+        m_done.notify_all();
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "MapLoader.h"
+
+// Prefetched maps are kept until they take this many bytes.
+constexpr size_t PREFETCH_BUDGET_BYTES = 64 * 1024 * 1024;
+
+// Number of threads decoding prefetched maps. The disc is the bottleneck, so
+// more threads mostly just compete with the map loader.
+constexpr size_t PREFETCH_NUM_WORKERS = 2;
+
+struct PrefetchStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t loaded = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+    size_t num_bytes = 0;
+};
+
+// MapPrefetcher decodes maps the user is likely to ask for next into a
+// bounded cache, on a few background threads. Everything it holds is CPU
+// data, the GPU upload still happens when a map is shown.
+class MapPrefetcher {
+public:
+    explicit MapPrefetcher(size_t num_workers = PREFETCH_NUM_WORKERS, size_t budget_bytes = PREFETCH_BUDGET_BYTES);
+    ~MapPrefetcher();
+    MapPrefetcher(const MapPrefetcher&) = delete;
+    MapPrefetcher& operator=(const MapPrefetcher&) = delete;
+
+    // prefetch replaces the queue with `keys`, most likely first. Maps that
+    // are already cached or loading are skipped.
+    auto prefetch(std::vector<MapKey> keys) -> void;
+
+    // take removes a prefetched map from the cache. If the map is still
+    // loading and `wait` is set, it blocks until it's done or `is_cancelled`
+    // returns true. A map that is only queued is dropped from the queue,
+    // since the caller will load it.
+    auto take(const MapKey& key, bool wait = false, const std::function<bool()>& is_cancelled = nullptr) -> std::optional<LoadedMap>;
+
+    // interrupt wakes callers blocked in take so they check `is_cancelled`
+    // again.
+    auto interrupt() -> void;
+
+    // put adds a map as most recently used, e.g. one that was taken but not
+    // shown after all.
+    auto put(LoadedMap loaded) -> void;
+
+    auto stats() const -> PrefetchStats;
+
+private:
+    auto run() -> void;
+    auto is_known(const MapKey& key) const -> bool;
+    auto insert(LoadedMap loaded) -> void;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::deque<MapKey> m_queue = {};
+    std::vector<MapKey> m_in_flight = {};
+    std::list<LoadedMap> m_maps = {}; // Most recently used first
+    SharedBytes m_shared = {};
+    size_t m_budget_bytes = 0;
+    PrefetchStats m_stats = {};
+    bool m_stop = false;
+
+    // Declared last so the threads start after everything they use.
+    std::vector<std::thread> m_threads;
+};
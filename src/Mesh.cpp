@@ -1,37 +1,67 @@
 #include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <numeric>
 #include <string>
+#include <tuple>
 #include <utility>
 
+#include "FFT.h"
 #include "Mesh.h"
 
 #include "glm/glm.hpp"
 
-Mesh::Mesh(std::string filename)
+// Meshes without indices are drawn as a plain triangle list, so they get
+// sequential indices.
+static auto sequential_indices(size_t count) -> std::vector<uint16_t>
 {
-    vertices = parse_obj(filename);
+    assert(count <= UINT16_MAX + 1);
+    std::vector<uint16_t> indices(count);
+    std::iota(indices.begin(), indices.end(), 0);
+    return indices;
+}
 
-    sg_buffer_desc vbuf_desc = {};
-    vbuf_desc.data = sg_range { vertices.data(), vertices.size() * sizeof(Vertex) };
-    vbuf_desc.label = "vertex-buffer";
-    vertex_buffer = sg_make_buffer(&vbuf_desc);
+Mesh::Mesh(std::string filename)
+    : Mesh(parse_obj(filename))
+{
 }
 
 Mesh::Mesh(std::vector<Vertex> _vertices)
+    : Mesh(_vertices, sequential_indices(_vertices.size()))
+{
+}
+
+Mesh::Mesh(std::vector<Vertex> _vertices, std::vector<uint16_t> _indices)
 {
-    vertices = _vertices;
+    vertices = std::move(_vertices);
+    indices = std::move(_indices);
+    num_vertices = vertices.size();
+    num_indices = indices.size();
+    std::tie(aabb, sphere) = compute_bounds(reinterpret_cast<const float*>(vertices.data()), vertices.size(), sizeof(Vertex) / sizeof(float));
+    chunks = build_chunks(vertices, indices, aabb);
+    upload(sg_range { vertices.data(), vertices.size() * sizeof(Vertex) }, sg_range { indices.data(), indices.size() * sizeof(uint16_t) });
+}
 
-    sg_buffer_desc vbuf_desc = {};
-    vbuf_desc.data = sg_range { _vertices.data(), _vertices.size() * sizeof(Vertex) };
-    vbuf_desc.label = "vertex-buffer";
-    vertex_buffer = sg_make_buffer(&vbuf_desc);
+// Map meshes keep no CPU copy. Their buffers are made straight from the
+// decoded arrays or the mapped cooked file.
+Mesh::Mesh(const MapMeshData& data)
+{
+    num_vertices = data.vertices.size();
+    num_indices = data.indices.size();
+    aabb = data.aabb;
+    sphere = data.sphere;
+    chunks.assign(data.chunks.begin(), data.chunks.end());
+    upload(sg_range { data.vertices.data(), data.vertices.size_bytes() }, sg_range { data.indices.data(), data.indices.size_bytes() });
 }
 
 Mesh::Mesh(std::vector<glm::vec3> _vertices)
 {
     vertices_float = _vertices;
+    num_vertices = vertices_float.size();
+    std::tie(aabb, sphere) = compute_bounds(reinterpret_cast<const float*>(vertices_float.data()), vertices_float.size(), sizeof(glm::vec3) / sizeof(float));
 
     sg_buffer_desc vbuf_desc = {};
     vbuf_desc.data = sg_range { _vertices.data(), _vertices.size() * sizeof(glm::vec3) };
@@ -39,6 +69,26 @@ Mesh::Mesh(std::vector<glm::vec3> _vertices)
     vertex_buffer = sg_make_buffer(&vbuf_desc);
 }
 
+Mesh::~Mesh()
+{
+    sg_destroy_buffer(vertex_buffer);
+    sg_destroy_buffer(index_buffer);
+}
+
+auto Mesh::upload(sg_range vertex_data, sg_range index_data) -> void
+{
+    sg_buffer_desc vbuf_desc = {};
+    vbuf_desc.data = vertex_data;
+    vbuf_desc.label = "vertex-buffer";
+    vertex_buffer = sg_make_buffer(&vbuf_desc);
+
+    sg_buffer_desc ibuf_desc = {};
+    ibuf_desc.type = SG_BUFFERTYPE_INDEXBUFFER;
+    ibuf_desc.data = index_data;
+    ibuf_desc.label = "index-buffer";
+    index_buffer = sg_make_buffer(&ibuf_desc);
+}
+
 std::vector<Vertex> Mesh::parse_obj(const std::string filename)
 {
     FILE* file = fopen(filename.c_str(), "r");
@@ -140,59 +190,20 @@ std::vector<Vertex> Mesh::parse_obj(const std::string filename)
 
 // normalized_scale returns a glm::vec3 that can be used to scale the mesh
 // to (-1, 1) on each coordinate.
-glm::vec3 Mesh::normalized_scale() const
+auto Mesh::normalized_scale() const -> glm::vec3
 {
-    float min_x = std::numeric_limits<float>::max();
-    float max_x = std::numeric_limits<float>::min();
-    float min_y = std::numeric_limits<float>::max();
-    float max_y = std::numeric_limits<float>::min();
-    float min_z = std::numeric_limits<float>::max();
-    float max_z = std::numeric_limits<float>::min();
-
-    for (const auto& vertex : vertices) {
-        min_x = std::min(min_x, vertex.position.x);
-        max_x = std::max(max_x, vertex.position.x);
-        min_y = std::min(min_y, vertex.position.y);
-        max_y = std::max(max_y, vertex.position.y);
-        min_z = std::min(min_z, vertex.position.z);
-        max_z = std::max(max_z, vertex.position.z);
+    glm::vec3 size = aabb.size();
+    float largest_dimension = std::max({ size.x, size.y, size.z });
+    if (largest_dimension == 0.0f) {
+        return glm::vec3(1.0f);
     }
-
-    float size_x = max_x - min_x;
-    float size_y = max_y - min_y;
-    float size_z = max_z - min_z;
-
-    float largest_dimension = std::max({ size_x, size_y, size_z });
     float scaling_factor = 2.0f / largest_dimension;
-
-    return glm::vec3(scaling_factor, scaling_factor, scaling_factor);
+    return glm::vec3(scaling_factor);
 }
 
 // center_translation returns a glm::vec3 that can be used to translate the
 // mesh to the center of (0, 0).
-glm::vec3 Mesh::center_translation() const
+auto Mesh::center_translation() const -> glm::vec3
 {
-    float min_x = std::numeric_limits<float>::max();
-    float max_x = std::numeric_limits<float>::min();
-    float min_y = std::numeric_limits<float>::max();
-    float max_y = std::numeric_limits<float>::min();
-    float min_z = std::numeric_limits<float>::max();
-    float max_z = std::numeric_limits<float>::min();
-
-    for (auto& vertex : vertices) {
-        // Min
-        min_x = std::min(vertex.position.x, min_x);
-        min_y = std::min(vertex.position.y, min_y);
-        min_z = std::min(vertex.position.z, min_z);
-        // Max
-        max_x = std::max(vertex.position.x, max_x);
-        max_y = std::max(vertex.position.y, max_y);
-        max_z = std::max(vertex.position.z, max_z);
-    }
-
-    float x = -(max_x + min_x) / 2.0;
-    float y = -(max_y + min_y) / 2.0;
-    float z = -(max_z + min_z) / 2.0;
-
-    return glm::vec3(x, y, z);
+    return -aabb.center();
 }
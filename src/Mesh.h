@@ -1,33 +1,50 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "Geometry.h"
+
 #include "glm/glm.hpp"
 #include "sokol_gfx.h"
 
-struct Vertex {
-    glm::vec3 position = {};
-    glm::vec3 normal = {};
-    glm::vec2 tex_coords = {};
-    float palette_index = {};
-};
+struct MapMeshData;
 
 class Mesh {
 public:
     Mesh(std::string filename);
     Mesh(std::vector<Vertex> vertices);
+    Mesh(std::vector<Vertex> vertices, std::vector<uint16_t> indices);
     Mesh(std::vector<glm::vec3> vertices);
-    ~Mesh() { sg_destroy_buffer(vertex_buffer); }
+    explicit Mesh(const MapMeshData& data);
+    ~Mesh();
 
     auto center_translation() const -> glm::vec3;
+    auto normalized_scale() const -> glm::vec3;
 
 public:
     std::vector<Vertex> vertices = {};
+    std::vector<uint16_t> indices = {};
     std::vector<glm::vec3> vertices_float = {};
     sg_buffer vertex_buffer = {};
+    sg_buffer index_buffer = {};
+
+    // Sizes of the GPU buffers. Map meshes keep no CPU copy, so `vertices`
+    // and `indices` are empty for them.
+    size_t num_vertices = 0;
+    size_t num_indices = 0;
+
+    // Computed once at construction. Both are empty for a mesh without
+    // vertices.
+    AABB aabb = {};
+    BoundingSphere sphere = {};
+
+    // Chunks cover the index buffer in order. Meshes smaller than a grid cell have
+    // a single chunk.
+    std::vector<MeshChunk> chunks = {};
 
 private:
+    auto upload(sg_range vertex_data, sg_range index_data) -> void;
     auto parse_obj(const std::string filename) -> std::vector<Vertex>;
-    auto normalized_scale() const -> glm::vec3;
 };
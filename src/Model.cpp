@@ -15,6 +15,63 @@ auto Model::update(float delta_time) -> void
     model_matrix = glm::scale(model_matrix, scale);
 }
 
+auto Model::cull(const Frustum* frustum, RenderStats& stats) -> bool
+{
+    draw_ranges.clear();
+
+    size_t num_triangles = mesh->num_indices / 3;
+    auto containment = Containment::Inside;
+    if (frustum != nullptr) {
+        containment = frustum->classify(mesh->aabb.transformed(model_matrix));
+    }
+
+    if (containment == Containment::Outside) {
+        stats.culled_objects++;
+        stats.culled_chunks += mesh->chunks.size();
+        stats.culled_triangles += num_triangles;
+        return false;
+    }
+
+    if (containment == Containment::Inside) {
+        draw_ranges.push_back({ 0, (uint32_t)mesh->num_indices });
+        stats.drawn_objects++;
+        stats.drawn_chunks += mesh->chunks.size();
+        stats.drawn_triangles += num_triangles;
+        return true;
+    }
+
+    // The mesh straddles the frustum, so test each chunk. Neighbouring
+    // visible chunks are merged into one draw.
+    for (const auto& chunk : mesh->chunks) {
+        if (frustum->classify(chunk.aabb.transformed(model_matrix)) == Containment::Outside) {
+            stats.culled_chunks++;
+            stats.culled_triangles += chunk.num_indices / 3;
+            continue;
+        }
+        stats.drawn_chunks++;
+        stats.drawn_triangles += chunk.num_indices / 3;
+        if (!draw_ranges.empty() && draw_ranges.back().first + draw_ranges.back().second == chunk.first_index) {
+            draw_ranges.back().second += chunk.num_indices;
+        } else {
+            draw_ranges.push_back({ chunk.first_index, chunk.num_indices });
+        }
+    }
+
+    if (draw_ranges.empty()) {
+        stats.culled_objects++;
+        return false;
+    }
+    stats.drawn_objects++;
+    return true;
+}
+
+auto Model::draw() -> void
+{
+    for (const auto& [first, count] : draw_ranges) {
+        sg_draw(first, count, 1);
+    }
+}
+
 ColoredModel::ColoredModel(std::shared_ptr<Mesh> _mesh, glm::vec4 _color, glm::vec3 _position)
     : Model(_position)
     , color(_color)
@@ -24,6 +81,7 @@ ColoredModel::ColoredModel(std::shared_ptr<Mesh> _mesh, glm::vec4 _color, glm::v
     mesh = _mesh;
     pipeline = resources->get_pipeline("colored")->get_pipeline();
     bindings.vertex_buffers[0] = mesh->vertex_buffer;
+    bindings.index_buffer = mesh->index_buffer;
 }
 
 auto ColoredModel::render() -> void
@@ -43,7 +101,7 @@ auto ColoredModel::render() -> void
     sg_range fs_range = SG_RANGE(fs_params);
     sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_standard_params, &vs_range);
     sg_apply_uniforms(SG_SHADERSTAGE_FS, SLOT_fs_colored_params, &fs_range);
-    sg_draw(0, mesh->vertices.size(), 1);
+    draw();
 }
 
 Light::Light(std::shared_ptr<Mesh> _mesh, glm::vec4 _color, glm::vec3 _position)
@@ -61,6 +119,7 @@ TexturedModel::TexturedModel(std::shared_ptr<Mesh> _mesh, std::shared_ptr<Textur
     mesh = _mesh;
     pipeline = resources->get_pipeline("textured")->get_pipeline();
     bindings.vertex_buffers[0] = mesh->vertex_buffer;
+    bindings.index_buffer = mesh->index_buffer;
 }
 
 auto TexturedModel::render() -> void
@@ -97,7 +156,7 @@ auto TexturedModel::render() -> void
     sg_range fs_range = SG_RANGE(fs_params);
     sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_standard_params, &vs_range);
     sg_apply_uniforms(SG_SHADERSTAGE_FS, SLOT_fs_textured_params, &fs_range);
-    sg_draw(0, mesh->vertices.size(), 1);
+    draw();
 }
 
 PalettedModel::PalettedModel(std::shared_ptr<Mesh> _mesh, std::shared_ptr<Texture> _texture, std::shared_ptr<Texture> _palette, glm::vec3 _position)
@@ -110,12 +169,13 @@ PalettedModel::PalettedModel(std::shared_ptr<Mesh> _mesh, std::shared_ptr<Textur
     mesh = _mesh;
     pipeline = resources->get_pipeline("paletted")->get_pipeline();
     bindings.vertex_buffers[0] = mesh->vertex_buffer;
+    bindings.index_buffer = mesh->index_buffer;
 }
 
 auto PalettedModel::render() -> void
 {
     auto state = State::get_instance();
-    vs_standard_params_t vs_params;
+    vs_map_params_t vs_params;
     vs_params.u_view_proj = state->orbital_camera.view_proj();
     vs_params.u_model = model_matrix;
 
@@ -145,9 +205,9 @@ auto PalettedModel::render() -> void
 
     sg_range vs_range = SG_RANGE(vs_params);
     sg_range fs_range = SG_RANGE(fs_params);
-    sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_standard_params, &vs_range);
+    sg_apply_uniforms(SG_SHADERSTAGE_VS, SLOT_vs_map_params, &vs_range);
     sg_apply_uniforms(SG_SHADERSTAGE_FS, SLOT_fs_paletted_params, &fs_range);
-    sg_draw(0, mesh->vertices.size(), 1);
+    draw();
 }
 
 Background::Background(std::pair<glm::vec4, glm::vec4> background)
@@ -162,6 +222,7 @@ Background::Background(glm::vec4 _top, glm::vec4 _bottom)
 {
     auto resources = ResourceManager::get_instance();
 
+    is_cullable = false;
     mesh = resources->get_mesh("background");
     pipeline = resources->get_pipeline("background")->get_pipeline();
     bindings.vertex_buffers[0] = mesh->vertex_buffer;
@@ -5,6 +5,7 @@
 #include <random>
 #include <vector>
 
+#include "Frustum.h"
 #include "Mesh.h"
 #include "Texture.h"
 #include "shader.glsl.h"
@@ -14,6 +15,16 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "sokol_gfx.h"
 
+// RenderStats counts what Scene::render drew and culled in a frame.
+struct RenderStats {
+    int drawn_objects = 0;
+    int culled_objects = 0;
+    int drawn_chunks = 0;
+    int culled_chunks = 0;
+    size_t drawn_triangles = 0;
+    size_t culled_triangles = 0;
+};
+
 class Model {
 public:
     Model(glm::vec3 position)
@@ -22,6 +33,10 @@ public:
     virtual auto render() -> void = 0;
     auto update(float delta_time) -> void;
 
+    // cull picks the chunks of the mesh that render() draws. A null frustum
+    // draws everything. Returns false if nothing is visible.
+    auto cull(const Frustum* frustum, RenderStats& stats) -> bool;
+
     glm::vec3 scale = { 1.0f, 1.0f, 1.0f };
     glm::vec3 translation = { 0.0f, 0.0f, 0.0f };
     glm::vec3 rotation = { 0.0f, 0.0f, 0.0f };
@@ -31,6 +46,15 @@ public:
     std::shared_ptr<Mesh> mesh = nullptr;
     sg_pipeline pipeline = {};
     sg_bindings bindings = {};
+
+    // Models that cover the screen, like the background, skip culling.
+    bool is_cullable = true;
+
+protected:
+    auto draw() -> void;
+
+    // Runs of visible chunks as (first index, index count), set by cull().
+    std::vector<std::pair<uint32_t, uint32_t>> draw_ranges = {};
 };
 
 class TexturedModel : public Model {
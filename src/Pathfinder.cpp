@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <functional>
+
+#include "Pathfinder.h"
+
+Pathfinder::Pathfinder(const Terrain& terrain)
+    : m_size_x(terrain.size_x)
+{
+    // Heights in half units, so half a slope stays an integer.
+    auto height_of = [](const TerrainTile& tile) {
+        return tile.height * 2 + tile.slope_height;
+    };
+
+    for (int level = 0; level < TERRAIN_LEVELS; level++) {
+        for (int z = 0; z < terrain.size_z; z++) {
+            for (int x = 0; x < terrain.size_x; x++) {
+                const auto* tile = terrain.tile(x, z, level);
+                bool unused = level > 0 && tile->is_empty();
+                m_walkable[tile_id(terrain, x, z, level)] = !unused && (tile->flags & TERRAIN_FLAG_UNWALKABLE) == 0;
+            }
+        }
+    }
+
+    constexpr std::array<std::pair<int, int>, 4> DIRECTIONS = { { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } } };
+    for (int level = 0; level < TERRAIN_LEVELS; level++) {
+        for (int z = 0; z < terrain.size_z; z++) {
+            for (int x = 0; x < terrain.size_x; x++) {
+                TileId from = tile_id(terrain, x, z, level);
+                if (!m_walkable[from]) {
+                    continue;
+                }
+                int from_height = height_of(*terrain.tile(x, z, level));
+                for (auto [dx, dz] : DIRECTIONS) {
+                    for (int to_level = 0; to_level < TERRAIN_LEVELS; to_level++) {
+                        const auto* neighbour = terrain.tile(x + dx, z + dz, to_level);
+                        if (neighbour == nullptr) {
+                            continue;
+                        }
+                        TileId to = tile_id(terrain, x + dx, z + dz, to_level);
+                        if (!m_walkable[to]) {
+                            continue;
+                        }
+                        Edge edge = {};
+                        edge.to = to;
+                        edge.climb = std::min(std::abs(height_of(*neighbour) - from_height), 255);
+                        edge.cost = neighbour->depth > 0 ? 2 : 1;
+                        m_edges[from * PATHFINDER_MAX_EDGES + m_edge_count[from]++] = edge;
+                    }
+                }
+            }
+        }
+    }
+
+    // Enough for the worst case, every edge relaxing once.
+    m_heap.reserve(PATHFINDER_MAX_TILES * PATHFINDER_MAX_EDGES + 1);
+    for (auto& bucket : m_buckets) {
+        bucket.reserve(PATHFINDER_MAX_TILES);
+    }
+    m_result.reserve(PATHFINDER_MAX_TILES);
+}
+
+auto Pathfinder::tile_id(const Terrain& terrain, int x, int z, int level) -> TileId
+{
+    return (level * TERRAIN_MAX_TILES) + (z * terrain.size_x) + x;
+}
+
+auto Pathfinder::cost(TileId tile) const -> int
+{
+    return m_stamp[tile] == m_generation ? m_cost[tile] : -1;
+}
+
+auto Pathfinder::begin_query() -> void
+{
+    m_generation++;
+    m_result.clear();
+    m_heap.clear();
+    for (auto& bucket : m_buckets) {
+        bucket.clear();
+    }
+}
+
+// Edge costs are 1 or 2, so tentative costs span at most three consecutive
+// values and a ring of three buckets is a complete priority queue (Dial).
+auto Pathfinder::reachable(TileId start, const MoveRules& rules) -> std::span<const TileId>
+{
+    begin_query();
+    if (!m_walkable[start]) {
+        return {};
+    }
+
+    m_stamp[start] = m_generation;
+    m_cost[start] = 0;
+    m_closed[start] = false;
+    m_buckets[0].push_back(start);
+
+    for (int cost = 0; cost <= rules.move; cost++) {
+        auto& bucket = m_buckets[cost % 3];
+        for (size_t i = 0; i < bucket.size(); i++) {
+            TileId tile = bucket[i];
+            if (m_closed[tile] || m_cost[tile] != cost) {
+                continue;
+            }
+            m_closed[tile] = true;
+            m_result.push_back(tile);
+
+            for (int e = 0; e < m_edge_count[tile]; e++) {
+                const auto& edge = m_edges[tile * PATHFINDER_MAX_EDGES + e];
+                int next_cost = cost + edge.cost;
+                if (next_cost > rules.move || !can_step(edge, rules)) {
+                    continue;
+                }
+                bool seen = m_stamp[edge.to] == m_generation;
+                if (seen && m_cost[edge.to] <= next_cost) {
+                    continue;
+                }
+                m_stamp[edge.to] = m_generation;
+                m_cost[edge.to] = next_cost;
+                m_parent[edge.to] = tile;
+                m_closed[edge.to] = false;
+                m_buckets[next_cost % 3].push_back(edge.to);
+            }
+        }
+        bucket.clear();
+    }
+    return m_result;
+}
+
+auto Pathfinder::find_path(TileId start, TileId goal, const MoveRules& rules) -> std::span<const TileId>
+{
+    begin_query();
+    if (!m_walkable[start] || !m_walkable[goal]) {
+        return {};
+    }
+
+    auto heuristic = [&](TileId tile) {
+        int x = (tile % TERRAIN_MAX_TILES) % m_size_x;
+        int z = (tile % TERRAIN_MAX_TILES) / m_size_x;
+        int goal_x = (goal % TERRAIN_MAX_TILES) % m_size_x;
+        int goal_z = (goal % TERRAIN_MAX_TILES) / m_size_x;
+        return std::abs(x - goal_x) + std::abs(z - goal_z);
+    };
+
+    // Min-heap on estimated total cost. Stale entries are skipped when
+    // popped instead of being updated in place.
+    auto compare = std::greater<std::pair<uint16_t, TileId>>();
+    m_stamp[start] = m_generation;
+    m_cost[start] = 0;
+    m_closed[start] = false;
+    m_heap.push_back({ heuristic(start), start });
+
+    while (!m_heap.empty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), compare);
+        TileId tile = m_heap.back().second;
+        m_heap.pop_back();
+        if (m_closed[tile]) {
+            continue;
+        }
+        m_closed[tile] = true;
+
+        if (tile == goal) {
+            for (TileId step = goal; step != start; step = m_parent[step]) {
+                m_result.push_back(step);
+            }
+            m_result.push_back(start);
+            std::reverse(m_result.begin(), m_result.end());
+            return m_result;
+        }
+
+        for (int e = 0; e < m_edge_count[tile]; e++) {
+            const auto& edge = m_edges[tile * PATHFINDER_MAX_EDGES + e];
+            if (!can_step(edge, rules)) {
+                continue;
+            }
+            int next_cost = m_cost[tile] + edge.cost;
+            bool seen = m_stamp[edge.to] == m_generation;
+            if (seen && m_cost[edge.to] <= next_cost) {
+                continue;
+            }
+            m_stamp[edge.to] = m_generation;
+            m_cost[edge.to] = next_cost;
+            m_parent[edge.to] = tile;
+            m_closed[edge.to] = false;
+            assert(m_heap.size() < m_heap.capacity());
+            m_heap.push_back({ next_cost + heuristic(edge.to), edge.to });
+            std::push_heap(m_heap.begin(), m_heap.end(), compare);
+        }
+    }
+    return {};
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Terrain.h"
+
+// TileId is a tile's index in Terrain::tiles, which encodes x, z and level.
+using TileId = uint16_t;
+
+constexpr int PATHFINDER_MAX_TILES = TERRAIN_LEVELS * TERRAIN_MAX_TILES;
+
+// Each tile connects to its four neighbours on both levels.
+constexpr int PATHFINDER_MAX_EDGES = 8;
+
+struct MoveRules {
+    int move = 4; // Movement points
+    int jump = 3; // Largest height step, up or down, in tile height units
+};
+
+// Pathfinder answers movement queries over a map's terrain. The graph is
+// built once per terrain into flat arrays, and every query reuses
+// preallocated storage, so queries never allocate.
+//
+// Walking onto a tile costs 1, or 2 if it has water. Heights are compared
+// at the middle of the tile, like Terrain::intersect.
+class Pathfinder {
+public:
+    explicit Pathfinder(const Terrain& terrain);
+
+    static auto tile_id(const Terrain& terrain, int x, int z, int level = 0) -> TileId;
+
+    auto is_walkable(TileId tile) const -> bool { return m_walkable[tile]; }
+
+    // reachable returns every tile a unit at `start` can move to, including
+    // `start`, using Dijkstra with a bucket queue. The span is valid until
+    // the next query.
+    auto reachable(TileId start, const MoveRules& rules) -> std::span<const TileId>;
+
+    // find_path returns the cheapest path from `start` to `goal` inclusive,
+    // using A* with a Manhattan heuristic, or an empty span if there is none.
+    // Movement points are not limited. The span is valid until the next
+    // query.
+    auto find_path(TileId start, TileId goal, const MoveRules& rules) -> std::span<const TileId>;
+
+    // cost returns the cost to reach `tile` found by the last query, or -1
+    // if the query didn't reach it.
+    auto cost(TileId tile) const -> int;
+
+private:
+    struct Edge {
+        TileId to;
+        uint8_t climb; // Height difference in half units
+        uint8_t cost;
+    };
+
+    auto begin_query() -> void;
+    auto can_step(const Edge& edge, const MoveRules& rules) const -> bool { return edge.climb <= rules.jump * 2; }
+
+    uint8_t m_size_x = 0;
+    std::array<bool, PATHFINDER_MAX_TILES> m_walkable = {};
+    std::array<uint8_t, PATHFINDER_MAX_TILES> m_edge_count = {};
+    std::array<Edge, PATHFINDER_MAX_TILES * PATHFINDER_MAX_EDGES> m_edges = {};
+
+    // Per query state. A tile's cost and parent are only valid when its
+    // stamp matches the current generation, so nothing is cleared between
+    // queries.
+    uint32_t m_generation = 0;
+    std::array<uint32_t, PATHFINDER_MAX_TILES> m_stamp = {};
+    std::array<uint16_t, PATHFINDER_MAX_TILES> m_cost = {};
+    std::array<TileId, PATHFINDER_MAX_TILES> m_parent = {};
+    std::array<bool, PATHFINDER_MAX_TILES> m_closed = {};
+
+    std::vector<std::pair<uint16_t, TileId>> m_heap = {};
+    std::vector<TileId> m_buckets[3] = {};
+    std::vector<TileId> m_result = {};
+};
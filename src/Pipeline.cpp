@@ -24,8 +24,8 @@ Pipeline::~Pipeline()
     sg_destroy_pipeline(pipeline);
 }
 
-// standard_desc is the description we use for basically everything.
-// It is missing the shader which will need to be added.
+// standard_desc is the description we use for basically everything. Meshes
+// are drawn indexed. It is missing the shader which will need to be added.
 auto Pipeline::standard_desc() -> sg_pipeline_desc
 {
 
@@ -34,10 +34,28 @@ auto Pipeline::standard_desc() -> sg_pipeline_desc
     desc.cull_mode = SG_CULLMODE_BACK;
     desc.face_winding = SG_FACEWINDING_CCW;
     desc.label = "pipeline";
+    desc.index_type = SG_INDEXTYPE_UINT16;
     desc.layout.attrs[ATTR_vs_standard_a_position].format = SG_VERTEXFORMAT_FLOAT3;
     desc.layout.attrs[ATTR_vs_standard_a_normal].format = SG_VERTEXFORMAT_FLOAT3;
     desc.layout.attrs[ATTR_vs_standard_a_uv].format = SG_VERTEXFORMAT_FLOAT2;
     desc.layout.attrs[ATTR_vs_standard_a_palette_index].format = SG_VERTEXFORMAT_FLOAT;
+    desc.layout.buffers[0].stride = sizeof(Vertex); // Skips Vertex::textured
+    desc.depth.write_enabled = true;
+    desc.depth.compare = SG_COMPAREFUNC_LESS_EQUAL;
+    return desc;
+}
+
+// map_desc is standard_desc for the packed MapVertex layout of map meshes.
+auto Pipeline::map_desc() -> sg_pipeline_desc
+{
+    sg_pipeline_desc desc = {};
+    desc.cull_mode = SG_CULLMODE_BACK;
+    desc.face_winding = SG_FACEWINDING_CCW;
+    desc.label = "map_pipeline";
+    desc.index_type = SG_INDEXTYPE_UINT16;
+    desc.layout.attrs[ATTR_vs_map_a_position].format = SG_VERTEXFORMAT_SHORT4;
+    desc.layout.attrs[ATTR_vs_map_a_normal].format = SG_VERTEXFORMAT_UINT10_N2;
+    desc.layout.attrs[ATTR_vs_map_a_uv].format = SG_VERTEXFORMAT_UBYTE4;
     desc.depth.write_enabled = true;
     desc.depth.compare = SG_COMPAREFUNC_LESS_EQUAL;
     return desc;
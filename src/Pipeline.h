@@ -15,6 +15,7 @@ public:
     ~Pipeline();
 
     static auto standard_desc() -> sg_pipeline_desc;
+    static auto map_desc() -> sg_pipeline_desc;
     static auto background_desc() -> sg_pipeline_desc;
 
     sg_pipeline get_pipeline() const { return pipeline; }
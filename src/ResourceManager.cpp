@@ -25,7 +25,7 @@ ResourceManager::ResourceManager()
     add_pipeline("colored", std::make_shared<Pipeline>(colored_shader));
 
     auto paletted_shader = add_shader("paletted", std::make_shared<Shader>(paletted_shader_desc(sg_query_backend())));
-    add_pipeline("paletted", std::make_shared<Pipeline>(paletted_shader));
+    add_pipeline("paletted", std::make_shared<Pipeline>(paletted_shader, Pipeline::map_desc()));
 
     auto background_shader = add_shader("background", std::make_shared<Shader>(background_shader_desc(sg_query_backend())));
     add_pipeline("background", std::make_shared<Pipeline>(background_shader, Pipeline::background_desc()));
@@ -100,6 +100,17 @@ auto ResourceManager::get_bin_reader() -> std::shared_ptr<BinReader>
     return bin_reader;
 }
 
+auto ResourceManager::set_cooked_cache(std::shared_ptr<CookedCache> cache) -> std::shared_ptr<CookedCache>
+{
+    this->cooked_cache = cache;
+    return cache;
+}
+
+auto ResourceManager::get_cooked_cache() -> std::shared_ptr<CookedCache>
+{
+    return cooked_cache;
+}
+
 auto ResourceManager::add_sampler(const std::string& name, std::shared_ptr<Sampler> sampler) -> std::shared_ptr<Sampler>
 {
     samplers[name] = sampler;
@@ -6,10 +6,12 @@
 #include <string>
 
 #include "BinReader.h"
+#include "CookedCache.h"
 #include "FFT.h"
 #include "Mesh.h"
 #include "Pipeline.h"
 #include "Shader.h"
+#include "Texture.h"
 
 class ResourceManager {
 public:
@@ -30,11 +32,15 @@ public:
     auto set_bin_reader(std::shared_ptr<BinReader> reader) -> std::shared_ptr<BinReader>;
     auto get_bin_reader() -> std::shared_ptr<BinReader>;
 
+    auto set_cooked_cache(std::shared_ptr<CookedCache> cache) -> std::shared_ptr<CookedCache>;
+    auto get_cooked_cache() -> std::shared_ptr<CookedCache>;
+
 private:
     ResourceManager();
     static ResourceManager* instance;
 
     std::shared_ptr<BinReader> bin_reader = nullptr;
+    std::shared_ptr<CookedCache> cooked_cache = nullptr;
 
     std::map<std::string, std::shared_ptr<Shader>> shaders = {};
     std::map<std::string, std::shared_ptr<Sampler>> samplers = {};
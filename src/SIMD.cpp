@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cstring>
+
+#include "SIMD.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HERETIC_SIMD_X86
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define HERETIC_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+auto unpack_4bpp_scalar(const uint8_t* in, size_t count, uint8_t* out) -> void
+{
+    for (size_t i = 0; i < count; i++) {
+        out[i * 2 + 0] = in[i] & 0x0F;
+        out[i * 2 + 1] = (in[i] & 0xF0) >> 4;
+    }
+}
+
+auto convert_i16_scalar(const uint8_t* in, size_t count, float scale, float* out) -> void
+{
+    for (size_t i = 0; i < count; i++) {
+        int16_t value;
+        std::memcpy(&value, in + i * 2, sizeof(value));
+        out[i] = static_cast<float>(value) * scale;
+    }
+}
+
+auto minmax_xyz_scalar(const float* in, size_t count, size_t stride, float* min, float* max) -> void
+{
+    for (size_t i = 0; i < count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            min[axis] = std::min(min[axis], in[i * stride + axis]);
+            max[axis] = std::max(max[axis], in[i * stride + axis]);
+        }
+    }
+}
+
+// The vector minmax_xyz kernels load four floats per triple and ignore the
+// fourth lane. The last triple is left to the scalar loop so the load never
+// reads past the end of `in`.
+
+#ifdef HERETIC_SIMD_X86
+
+static auto unpack_4bpp_sse2(const uint8_t* in, size_t count, uint8_t* out) -> void
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i right = _mm_and_si128(packed, mask);
+        __m128i left = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2 + 0), _mm_unpacklo_epi8(right, left));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2 + 16), _mm_unpackhi_epi8(right, left));
+    }
+    unpack_4bpp_scalar(in + i, count - i, out + i * 2);
+}
+
+// AVX2 unpacks within 128-bit lanes, so the halves are swapped back into
+// order before storing.
+__attribute__((target("avx2"))) static auto unpack_4bpp_avx2(const uint8_t* in, size_t count, uint8_t* out) -> void
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i right = _mm256_and_si256(packed, mask);
+        __m256i left = _mm256_and_si256(_mm256_srli_epi16(packed, 4), mask);
+        __m256i lo = _mm256_unpacklo_epi8(right, left);
+        __m256i hi = _mm256_unpackhi_epi8(right, left);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 2 + 0), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 2 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    unpack_4bpp_sse2(in + i, count - i, out + i * 2);
+}
+
+static auto convert_i16_sse2(const uint8_t* in, size_t count, float scale, float* out) -> void
+{
+    const __m128 factor = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2));
+        // Sign extend by placing each value in the high half and shifting down.
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+        _mm_storeu_ps(out + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(lo), factor));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), factor));
+    }
+    convert_i16_scalar(in + i * 2, count - i, scale, out + i);
+}
+
+__attribute__((target("avx2"))) static auto convert_i16_avx2(const uint8_t* in, size_t count, float scale, float* out) -> void
+{
+    const __m256 factor = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2 + 0));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2 + 16));
+        _mm256_storeu_ps(out + i + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(lo)), factor));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(hi)), factor));
+    }
+    convert_i16_sse2(in + i * 2, count - i, scale, out + i);
+}
+
+static auto minmax_xyz_sse2(const float* in, size_t count, size_t stride, float* min, float* max) -> void
+{
+    if (count == 0) {
+        return;
+    }
+    __m128 lo = _mm_setr_ps(min[0], min[1], min[2], 0.0f);
+    __m128 hi = _mm_setr_ps(max[0], max[1], max[2], 0.0f);
+    size_t i = 0;
+    for (; i + 1 < count; i++) {
+        __m128 xyz = _mm_loadu_ps(in + i * stride);
+        lo = _mm_min_ps(lo, xyz);
+        hi = _mm_max_ps(hi, xyz);
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, lo);
+    std::memcpy(min, lanes, 3 * sizeof(float));
+    _mm_store_ps(lanes, hi);
+    std::memcpy(max, lanes, 3 * sizeof(float));
+    minmax_xyz_scalar(in + i * stride, count - i, stride, min, max);
+}
+
+// AVX2 takes two triples per iteration, one in each 128-bit lane, and folds
+// the lanes together at the end.
+__attribute__((target("avx2"))) static auto minmax_xyz_avx2(const float* in, size_t count, size_t stride, float* min, float* max) -> void
+{
+    if (count == 0) {
+        return;
+    }
+    __m128 initial_lo = _mm_setr_ps(min[0], min[1], min[2], 0.0f);
+    __m128 initial_hi = _mm_setr_ps(max[0], max[1], max[2], 0.0f);
+    __m256 lo = _mm256_set_m128(initial_lo, initial_lo);
+    __m256 hi = _mm256_set_m128(initial_hi, initial_hi);
+    size_t i = 0;
+    for (; i + 2 < count; i += 2) {
+        __m256 xyz = _mm256_set_m128(_mm_loadu_ps(in + (i + 1) * stride), _mm_loadu_ps(in + i * stride));
+        lo = _mm256_min_ps(lo, xyz);
+        hi = _mm256_max_ps(hi, xyz);
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, _mm_min_ps(_mm256_castps256_ps128(lo), _mm256_extractf128_ps(lo, 1)));
+    std::memcpy(min, lanes, 3 * sizeof(float));
+    _mm_store_ps(lanes, _mm_max_ps(_mm256_castps256_ps128(hi), _mm256_extractf128_ps(hi, 1)));
+    std::memcpy(max, lanes, 3 * sizeof(float));
+    minmax_xyz_sse2(in + i * stride, count - i, stride, min, max);
+}
+
+#endif
+
+#ifdef HERETIC_SIMD_NEON
+
+static auto unpack_4bpp_neon(const uint8_t* in, size_t count, uint8_t* out) -> void
+{
+    const uint8x16_t mask = vdupq_n_u8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t packed = vld1q_u8(in + i);
+        uint8x16x2_t nibbles = { { vandq_u8(packed, mask), vshrq_n_u8(packed, 4) } };
+        vst2q_u8(out + i * 2, nibbles);
+    }
+    unpack_4bpp_scalar(in + i, count - i, out + i * 2);
+}
+
+static auto convert_i16_neon(const uint8_t* in, size_t count, float scale, float* out) -> void
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t values = vreinterpretq_s16_u8(vld1q_u8(in + i * 2));
+        vst1q_f32(out + i + 0, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(values))), scale));
+        vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(values))), scale));
+    }
+    convert_i16_scalar(in + i * 2, count - i, scale, out + i);
+}
+
+static auto minmax_xyz_neon(const float* in, size_t count, size_t stride, float* min, float* max) -> void
+{
+    if (count == 0) {
+        return;
+    }
+    float32x4_t lo = { min[0], min[1], min[2], 0.0f };
+    float32x4_t hi = { max[0], max[1], max[2], 0.0f };
+    size_t i = 0;
+    for (; i + 1 < count; i++) {
+        float32x4_t xyz = vld1q_f32(in + i * stride);
+        lo = vminq_f32(lo, xyz);
+        hi = vmaxq_f32(hi, xyz);
+    }
+    float lanes[4];
+    vst1q_f32(lanes, lo);
+    std::memcpy(min, lanes, 3 * sizeof(float));
+    vst1q_f32(lanes, hi);
+    std::memcpy(max, lanes, 3 * sizeof(float));
+    minmax_xyz_scalar(in + i * stride, count - i, stride, min, max);
+}
+
+#endif
+
+static auto supported_paths() -> std::vector<SIMDPath>
+{
+    std::vector<SIMDPath> paths = { { "Scalar", unpack_4bpp_scalar, convert_i16_scalar, minmax_xyz_scalar } };
+#if defined(HERETIC_SIMD_X86)
+    paths.push_back({ "SSE2", unpack_4bpp_sse2, convert_i16_sse2, minmax_xyz_sse2 });
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        paths.push_back({ "AVX2", unpack_4bpp_avx2, convert_i16_avx2, minmax_xyz_avx2 });
+    }
+#elif defined(HERETIC_SIMD_NEON)
+    paths.push_back({ "NEON", unpack_4bpp_neon, convert_i16_neon, minmax_xyz_neon });
+#endif
+    return paths;
+}
+
+auto simd_paths() -> const std::vector<SIMDPath>&
+{
+    static const std::vector<SIMDPath> paths = supported_paths();
+    return paths;
+}
+
+// The fastest path is the last one.
+static auto kernels() -> const SIMDPath&
+{
+    static const SIMDPath& selected = simd_paths().back();
+    return selected;
+}
+
+auto unpack_4bpp(const uint8_t* in, size_t count, uint8_t* out) -> void
+{
+    kernels().unpack_4bpp(in, count, out);
+}
+
+auto convert_i16(const uint8_t* in, size_t count, float scale, float* out) -> void
+{
+    kernels().convert_i16(in, count, scale, out);
+}
+
+auto minmax_xyz(const float* in, size_t count, size_t stride, float* min, float* max) -> void
+{
+    kernels().minmax_xyz(in, count, stride, min, max);
+}
+
+auto simd_path() -> const char*
+{
+    return kernels().name;
+}
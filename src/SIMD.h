@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Vectorized kernels for decoding disc data. Each kernel has a scalar
+// reference implementation, and the fastest code path the CPU supports is
+// picked at runtime: AVX2 or SSE2 on x86-64, NEON on ARM64.
+
+// unpack_4bpp expands `count` packed 4bpp bytes into one palette index per
+// byte. Each byte holds two indices, low nibble first. `out` must hold
+// `count * 2` bytes.
+auto unpack_4bpp(const uint8_t* in, size_t count, uint8_t* out) -> void;
+auto unpack_4bpp_scalar(const uint8_t* in, size_t count, uint8_t* out) -> void;
+
+// convert_i16 converts `count` little-endian int16 values to floats
+// multiplied by `scale`. `in` needs no particular alignment.
+auto convert_i16(const uint8_t* in, size_t count, float scale, float* out) -> void;
+auto convert_i16_scalar(const uint8_t* in, size_t count, float scale, float* out) -> void;
+
+// minmax_xyz widens `min` and `max` (three floats each) to cover `count`
+// xyz triples spaced `stride` floats apart, e.g. the positions of an array
+// of vertices. `stride` must be at least 3.
+auto minmax_xyz(const float* in, size_t count, size_t stride, float* min, float* max) -> void;
+auto minmax_xyz_scalar(const float* in, size_t count, size_t stride, float* min, float* max) -> void;
+
+// simd_path returns the name of the code path picked at runtime.
+auto simd_path() -> const char*;
+
+// SIMDPath is one code path's set of kernels.
+struct SIMDPath {
+    const char* name;
+    void (*unpack_4bpp)(const uint8_t* in, size_t count, uint8_t* out);
+    void (*convert_i16)(const uint8_t* in, size_t count, float scale, float* out);
+    void (*minmax_xyz)(const float* in, size_t count, size_t stride, float* min, float* max);
+};
+
+// simd_paths lists every code path compiled in that this CPU supports,
+// scalar first and fastest last, so all of them can be checked against the
+// scalar reference.
+auto simd_paths() -> const std::vector<SIMDPath>&;
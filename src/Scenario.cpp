@@ -1,86 +1,40 @@
+#include <cassert>
 #include <iomanip>
 #include <sstream>
 
 #include "FFT.h"
 #include "Scenario.h"
 
-bool Scenario::operator==(const Scenario& other) const
+static auto read_u16(const uint8_t* raw, size_t offset) -> uint16_t
 {
-    return id() == other.id();
+    return raw[offset] | (raw[offset + 1] << 8);
 }
 
-auto Scenario::repr() const -> std::string
-{
-    std::ostringstream oss;
-    oss << std::setw(3) << std::setfill('0') << id() << " " << map_list[map_id()].name;
-    return oss.str();
-}
-
-auto Scenario::id() const -> int
-{
-    return data[0] | (data[1] << 8);
-}
-
-auto Scenario::map_id() const -> int
-{
-    return data[2];
-}
-
-auto Scenario::weather() const -> MapWeather
-{
-    return static_cast<MapWeather>(data[3]);
-}
-
-auto Scenario::time() const -> MapTime
-{
-    return static_cast<MapTime>(data[4]);
-}
-
-auto Scenario::first_music() const -> int
-{
-    return data[5];
-}
-
-auto Scenario::second_music() const -> int
+Scenario::Scenario(std::span<const uint8_t> bytes)
 {
-    return data[6];
-}
-
-auto Scenario::entd_id() const -> int
-{
-    return data[7] | (data[8] << 8);
-}
+    assert(bytes.size() >= SCENARIO_SIZE);
+    const uint8_t* raw = bytes.data();
 
-auto Scenario::first_grid() const -> int
-{
-    return data[9] | (data[10] << 8);
-}
-
-auto Scenario::second_grid() const -> int
-{
-    return data[11] | (data[12] << 8);
-}
-
-auto Scenario::require_ramza_unknown() const -> int
-{
-    return data[17];
+    id = read_u16(raw, ScenarioLayout::id);
+    map_id = raw[ScenarioLayout::map_id];
+    weather = static_cast<MapWeather>(raw[ScenarioLayout::weather]);
+    time = static_cast<MapTime>(raw[ScenarioLayout::time]);
+    first_music = raw[ScenarioLayout::first_music];
+    second_music = raw[ScenarioLayout::second_music];
+    entd_id = read_u16(raw, ScenarioLayout::entd_id);
+    first_grid = read_u16(raw, ScenarioLayout::first_grid);
+    second_grid = read_u16(raw, ScenarioLayout::second_grid);
+    require_ramza_unknown = raw[ScenarioLayout::require_ramza_unknown];
+    next_scenario = read_u16(raw, ScenarioLayout::next_scenario);
+    next_step = raw[ScenarioLayout::next_step];
+    event_id = read_u16(raw, ScenarioLayout::event_id);
 }
 
-auto Scenario::next_scenario() const -> int
-{
-    return data[18] | (data[19] << 8);
-}
-
-auto Scenario::next_step() const -> int
-{
-    return data[20];
-}
-
-auto Scenario::event_id() const -> int
+auto Scenario::repr() const -> std::string
 {
-    assert(false); // See header file documentation.
-
-    return (data[22] | (data[23] << 8));
+    std::ostringstream oss;
+    oss << std::setw(3) << std::setfill('0') << id << " " << map_list[map_id].name;
+    return oss.str();
 }
 
 // Thanks to FFTPAtcher for the scenario name list.
@@ -1,57 +1,77 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <span>
 #include <string>
-#include <vector>
+#include <type_traits>
 
 #include "FFT.h"
 
-// Scenario represents a battle information.
-class Scenario {
-public:
+constexpr size_t SCENARIO_SIZE = 24;
+
+// ScenarioLayout is the byte offset of each field in a raw ATTACK.OUT
+// scenario.
+struct ScenarioLayout {
+    static constexpr size_t id = 0;
+    static constexpr size_t map_id = 2;
+    static constexpr size_t weather = 3;
+    static constexpr size_t time = 4;
+    static constexpr size_t first_music = 5;
+    static constexpr size_t second_music = 6;
+    static constexpr size_t entd_id = 7;
+    static constexpr size_t first_grid = 9;
+    static constexpr size_t second_grid = 11;
+    static constexpr size_t require_ramza_unknown = 17;
+    static constexpr size_t next_scenario = 18;
+    static constexpr size_t next_step = 20;
+    static constexpr size_t event_id = 22;
+};
+static_assert(ScenarioLayout::event_id + sizeof(uint16_t) == SCENARIO_SIZE);
+
+// Scenario represents a battle information, decoded once from its raw bytes.
+struct Scenario {
     Scenario() = default;
-    Scenario(std::vector<uint8_t> data)
-        : data(data) {};
+    explicit Scenario(std::span<const uint8_t> bytes);
 
-    bool operator==(const Scenario& other) const;
+    bool operator==(const Scenario& other) const { return id == other.id; }
 
     auto repr() const -> std::string;
 
     // This is the ID of the scenario, but it is also the index into events.
-    auto id() const -> int;
+    uint16_t id = 0;
 
-    // map_id() returns the ID from our map_list.
-    auto map_id() const -> int;
+    // The ID from our map_list.
+    uint8_t map_id = 0;
 
-    auto weather() const -> MapWeather;
-    auto time() const -> MapTime;
+    MapWeather weather = MapWeather::None;
+    MapTime time = MapTime::Day;
 
-    auto first_music() const -> int;
-    auto second_music() const -> int;
+    uint8_t first_music = 0;
+    uint8_t second_music = 0;
 
-    auto entd_id() const -> int;
+    uint16_t entd_id = 0;
 
-    auto first_grid() const -> int;
-    auto second_grid() const -> int;
+    uint16_t first_grid = 0;
+    uint16_t second_grid = 0;
 
-    auto require_ramza_unknown() const -> int;
+    uint8_t require_ramza_unknown = 0;
 
-    // next_step() returns the next step in the scenario. Options:
+    // next_step is the next step in the scenario. Options:
     // - 0x80 = World map
-    // - 0x81 = Scenario (next_scenario())
+    // - 0x81 = Scenario (next_scenario)
     // - 0x82 = Game reset follows
-    auto next_step() const -> int;
+    uint8_t next_step = 0;
 
-    // next_scenario() returns the next scenario id if next_step() is 0x81.
-    auto next_scenario() const -> int;
+    // next_scenario is the next scenario id if next_step is 0x81.
+    uint16_t next_scenario = 0;
 
-    // The docs describe this as the event_id() but you should use the
-    // Scenario.id() as the index into events. This is currently unused. Actual
+    // The docs describe this as the event_id but you should use the
+    // Scenario.id as the index into events. This is currently unused. Actual
     // events that we care about (non setup) will have this as 0.
-    auto event_id() const -> int;
-
-private:
-    std::vector<uint8_t> data;
+    uint16_t event_id = 0;
 };
+static_assert(std::is_trivially_copyable_v<Scenario>);
+static_assert(sizeof(Scenario) == 20);
 
 extern std::map<int, std::string> scenario_list;
@@ -1,5 +1,7 @@
 #include "Scene.h"
+#include "Frustum.h"
 #include "Model.h"
+#include "State.h"
 
 auto Scene::add_model(std::shared_ptr<Model> model) -> void
 {
@@ -23,12 +25,18 @@ auto Scene::update(float delta_time) -> void
 
 auto Scene::render() -> void
 {
+    stats = {};
+    Frustum frustum(State::get_instance()->orbital_camera.view_proj());
+    const Frustum* culling = use_culling ? &frustum : nullptr;
+
     for (auto& model : models) {
-        model->render();
+        if (!model->is_cullable || model->cull(culling, stats)) {
+            model->render();
+        }
     }
 
     for (auto& light : lights) {
-        if (light->is_enabled) {
+        if (light->is_enabled && light->cull(culling, stats)) {
             light->render();
         }
     }
@@ -17,6 +17,9 @@ public:
 
     float rotation_speed = 0.0f;
 
+    bool use_culling = true;
+    RenderStats stats = {};
+
     int map_num = 49;
     bool use_lighting = true;
     glm::vec4 ambient_color = {};
@@ -0,0 +1,80 @@
+#include <cstring>
+
+#include "SectorCache.h"
+
+SectorCache::SectorCache(size_t capacity)
+    : m_capacity(capacity)
+{
+}
+
+auto SectorCache::get(uint32_t sector_num, uint8_t* out) -> bool
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_lookup.find(sector_num);
+    if (it == m_lookup.end()) {
+        m_stats.misses++;
+        return false;
+    }
+
+    m_sectors.splice(m_sectors.begin(), m_sectors, it->second);
+    std::memcpy(out, it->second->second.data(), SECTOR_SIZE);
+
+    m_stats.hits++;
+    m_stats.bytes_served += SECTOR_SIZE;
+    return true;
+}
+
+auto SectorCache::put(uint32_t sector_num, const uint8_t* data) -> void
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_capacity == 0) {
+        return;
+    }
+
+    auto it = m_lookup.find(sector_num);
+    if (it != m_lookup.end()) {
+        m_sectors.splice(m_sectors.begin(), m_sectors, it->second);
+        return;
+    }
+
+    evict_to(m_capacity - 1);
+
+    m_sectors.emplace_front();
+    m_sectors.front().first = sector_num;
+    std::memcpy(m_sectors.front().second.data(), data, SECTOR_SIZE);
+    m_lookup[sector_num] = m_sectors.begin();
+}
+
+auto SectorCache::capacity() const -> size_t
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_capacity;
+}
+
+auto SectorCache::set_capacity(size_t capacity) -> void
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    evict_to(m_capacity);
+}
+
+auto SectorCache::stats() const -> SectorCacheStats
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto stats = m_stats;
+    stats.size = m_sectors.size();
+    stats.capacity = m_capacity;
+    return stats;
+}
+
+// evict_to drops least recently used sectors until at most `size` remain.
+// The caller must hold the lock.
+auto SectorCache::evict_to(size_t size) -> void
+{
+    while (m_sectors.size() > size) {
+        m_lookup.erase(m_sectors.back().first);
+        m_sectors.pop_back();
+        m_stats.evictions++;
+    }
+}
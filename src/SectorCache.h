@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "FFT.h"
+
+struct SectorCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t bytes_served = 0;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    auto hit_rate() const -> double { return hits + misses == 0 ? 0.0 : (double)hits / (double)(hits + misses); }
+};
+
+// SectorCache is a bounded LRU of sector user data (SECTOR_SIZE bytes) keyed
+// by sector number. It is internally locked so a shared BinReader stays safe
+// to use from several threads.
+class SectorCache {
+public:
+    explicit SectorCache(size_t capacity);
+
+    // get copies the sector to `out` and returns true if it is cached.
+    auto get(uint32_t sector_num, uint8_t* out) -> bool;
+    auto put(uint32_t sector_num, const uint8_t* data) -> void;
+
+    auto capacity() const -> size_t;
+    auto set_capacity(size_t capacity) -> void;
+    auto stats() const -> SectorCacheStats;
+
+private:
+    using Sector = std::pair<uint32_t, std::array<uint8_t, SECTOR_SIZE>>;
+
+    auto evict_to(size_t size) -> void;
+
+    mutable std::mutex m_mutex;
+    size_t m_capacity = 0;
+
+    // Most recently used sectors are at the front.
+    std::list<Sector> m_sectors = {};
+    std::unordered_map<uint32_t, std::list<Sector>::iterator> m_lookup = {};
+
+    SectorCacheStats m_stats = {};
+};
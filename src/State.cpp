@@ -1,15 +1,29 @@
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <optional>
 
 #include "Dispatcher.h"
 #include "FFT.h"
 #include "Model.h"
-#include "ResourceManager.h"
 #include "State.h"
 
 State* State::instance = nullptr;
 
+// At most this many styles of the current map are prefetched.
+constexpr size_t PREFETCH_MAX_STYLES = 4;
+
+// step_map returns the next valid map after `map_num` in the direction of
+// `step`, wrapping around map_list.
+static auto step_map(int map_num, int step) -> int
+{
+    int size = map_list.size();
+    do {
+        map_num = (map_num + step + size) % size;
+    } while (!map_list[map_num].valid);
+    return map_num;
+}
+
 auto State::set_scenario(Scenario scenario) -> void
 {
     auto it = std::find(scenarios.begin(), scenarios.end(), scenario);
@@ -23,20 +37,33 @@ auto State::set_scenario(Scenario scenario) -> void
 
     current_style_index = 0;
 
-    current_event = events[scenario.id()];
+    current_event = events[scenario.id];
     current_scenario = scenario;
 
-    set_map(scenario.map_id(), scenario.time(), scenario.weather());
+    // The event's camera moves belong to the scenario's map, so the event
+    // waits until that map is on screen. It already is on a cache hit.
+    set_map(scenario.map_id, scenario.time, scenario.weather);
+    pending_event_map = MapKey { current_map_index, scenario.time, scenario.weather };
+    dispatch_pending_event();
+}
+
+// dispatch_pending_event dispatches current_event once the map it was
+// waiting for is on screen.
+auto State::dispatch_pending_event() -> void
+{
+    if (!pending_event_map.has_value() || !(*pending_event_map == current_map_key)) {
+        return;
+    }
+    pending_event_map = std::nullopt;
 
     auto dispatcher = Dispatcher::get_instance();
     dispatcher->dispatch(current_event);
 }
 
-auto State::set_map(int map_num, MapTime time, MapWeather weather, int arrangement) -> bool
+auto State::set_map(int map_num, MapTime time, MapWeather weather, int arrangement) -> void
 {
-    auto state = State::get_instance();
-    auto resources = ResourceManager::get_instance();
-    auto reader = resources->get_bin_reader();
+    // Any other map change drops a scenario event still waiting for its map.
+    pending_event_map = std::nullopt;
 
     while (true) {
         auto desc = map_list[map_num];
@@ -51,35 +78,164 @@ auto State::set_map(int map_num, MapTime time, MapWeather weather, int arrangeme
         break;
     }
 
-    auto map = reader->read_map(map_num, time, weather, arrangement);
-    if (map == nullptr) {
-        std::cout << "Failed to load map: " << map_num << std::endl;
-        return false;
+    current_map_index = map_num;
+
+    MapKey key = { map_num, time, weather, arrangement };
+    auto cached = map_cache.get(key);
+    if (cached != nullptr) {
+        map_loader.cancel();
+        show_map(*cached);
+        return;
+    }
+
+    auto prefetched = map_prefetcher.take(key);
+    if (prefetched.has_value()) {
+        map_loader.cancel();
+        show_map(*map_cache.upload(*prefetched));
+        return;
+    }
+
+    map_loader.request(key);
+    prefetch_neighbours();
+}
+
+auto State::update_map() -> void
+{
+    auto loaded = map_loader.poll();
+    if (!loaded.has_value()) {
+        return;
+    }
+    if (loaded->map == nullptr) {
+        std::cout << "Failed to load map: " << loaded->key.map_num << std::endl;
+        return;
     }
 
-    auto map_mesh = std::make_shared<Mesh>(map->mesh->vertices);
-    auto map_model = std::make_shared<PalettedModel>(map_mesh, map->texture, map->mesh->palette);
-    auto background = std::make_shared<Background>(map->mesh->background);
-    auto map_center_translation = map_mesh->center_translation();
-    map_model->translation = map_center_translation;
+    auto gpu_map = map_cache.upload(*loaded);
+    show_map(*gpu_map);
+    std::cout << "Loaded map " << loaded->key.repr() << " in " << loaded->milliseconds << "ms" << std::endl;
+}
 
-    state->records = map->gns_records;
+auto State::show_map(const GPUMap& gpu_map) -> void
+{
+    const auto& map = gpu_map.loaded.map;
 
-    state->scene.clear();
-    state->scene.add_model(background);
-    state->scene.add_model(map_model);
-    state->scene.ambient_color = map->mesh->ambient_color;
+    records = map->gns_records;
+    current_map_mesh = map->mesh;
+    current_map_model = gpu_map.models.empty() ? nullptr : gpu_map.models.front();
+    current_map_bvh = gpu_map.loaded.bvh;
+    current_map_pathfinder = gpu_map.loaded.pathfinder;
+    picked = std::nullopt;
+    picked_tile = std::nullopt;
 
-    // Add lights with the same translation from the map. We don't take the
-    // lights position into the center_translation calculation because they are
-    // so far away.
-    for (std::shared_ptr<Light> light : map->mesh->lights) {
-        light->translation += map_center_translation;
-        state->scene.add_light(light);
+    scene.clear();
+    scene.add_model(gpu_map.background);
+    for (const auto& model : gpu_map.models) {
+        scene.add_model(model);
+    }
+    scene.ambient_color = map->mesh->ambient_color;
+    for (const auto& light : gpu_map.lights) {
+        scene.add_light(light);
     }
 
-    current_map_index = map_num;
-    return true;
+    current_map_key = gpu_map.loaded.key;
+    dispatch_pending_event();
+    prefetch_neighbours();
+}
+
+// prefetch_neighbours queues the maps most likely to be asked for next, most
+// likely first: the neighbours in map_list (J/K), the neighbouring scenarios
+// (U/I), the scenario that follows the current one, then other styles of the
+// map on screen. Maps already in the GPU cache or being loaded by the map
+// loader are skipped.
+auto State::prefetch_neighbours() -> void
+{
+    std::optional<MapKey> loading = std::nullopt;
+    if (map_loader.is_loading()) {
+        loading = map_loader.loading_key();
+    }
+
+    std::vector<MapKey> keys;
+    auto add = [&](const MapKey& key) -> bool {
+        if (key == current_map_key || key == loading || map_cache.contains(key) || std::find(keys.begin(), keys.end(), key) != keys.end()) {
+            return false;
+        }
+        keys.push_back(key);
+        return true;
+    };
+
+    add({ step_map(current_map_index, 1) });
+    add({ step_map(current_map_index, -1) });
+
+    if (current_scenario_index >= 0 && !scenarios.empty()) {
+        int num_scenarios = scenarios.size();
+        for (int step : { 1, -1 }) {
+            const auto& scenario = scenarios[(current_scenario_index + step + num_scenarios) % num_scenarios];
+            add({ scenario.map_id, scenario.time, scenario.weather });
+        }
+        if (current_scenario.next_step == 0x81) {
+            auto it = std::find_if(scenarios.begin(), scenarios.end(), [&](const Scenario& s) { return s.id == current_scenario.next_scenario; });
+            if (it != scenarios.end()) {
+                add({ it->map_id, it->time, it->weather });
+            }
+        }
+    }
+
+    // Records are only known for the map on screen.
+    if (current_map_key.map_num == current_map_index) {
+        size_t num_styles = 0;
+        for (const auto& record : records) {
+            if (num_styles == PREFETCH_MAX_STYLES) {
+                break;
+            }
+            if (record.resource_type != ResourceType::Texture && record.resource_type != ResourceType::MeshAlt) {
+                continue;
+            }
+            if (add({ current_map_index, record.time, record.weather, record.arrangement })) {
+                num_styles++;
+            }
+        }
+    }
+
+    map_prefetcher.prefetch(std::move(keys));
+}
+
+auto State::pick(float mouse_x, float mouse_y) -> void
+{
+    if (current_map_bvh == nullptr || current_map_model == nullptr) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Unproject the cursor at the near and far planes straight into model
+    // space, where the BVH was built.
+    float x = (mouse_x / sapp_widthf()) * 2.0f - 1.0f;
+    float y = 1.0f - (mouse_y / sapp_heightf()) * 2.0f;
+    auto inverse = glm::inverse(orbital_camera.view_proj() * current_map_model->model_matrix);
+    glm::vec4 near = inverse * glm::vec4(x, y, -1.0f, 1.0f);
+    glm::vec4 far = inverse * glm::vec4(x, y, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(near) / near.w;
+    Ray ray = { origin, glm::vec3(far) / far.w - origin };
+
+    auto hit = current_map_bvh->intersect(ray);
+    if (hit.has_value()) {
+        PickResult result = {};
+        result.triangle = hit->triangle;
+        result.polygon = current_map_mesh->polygons[hit->triangle];
+        result.position = glm::vec3(current_map_model->model_matrix * glm::vec4(hit->position, 1.0f));
+        picked = result;
+    } else {
+        picked = std::nullopt;
+    }
+    picked_tile = current_map_mesh->terrain.intersect(ray);
+
+    reachable_tiles = 0;
+    if (picked_tile.has_value() && current_map_pathfinder != nullptr) {
+        auto tile = Pathfinder::tile_id(current_map_mesh->terrain, picked_tile->x, picked_tile->z, picked_tile->level);
+        reachable_tiles = current_map_pathfinder->reachable(tile, move_rules).size();
+    }
+
+    pick_microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
 }
 
 auto State::next_scenario() -> void
@@ -117,41 +273,13 @@ auto State::previous_scenario() -> void
 auto State::next_map() -> void
 {
     auto state = State::get_instance();
-
-    state->current_map_index++;
-
-    while (true) {
-        auto desc = map_list[state->current_map_index];
-        if (!desc.valid) {
-            state->current_map_index++;
-            if (state->current_map_index >= (int)map_list.size()) {
-                state->current_map_index = 0;
-            }
-            continue;
-        }
-        break;
-    }
-
+    state->current_map_index = step_map(state->current_map_index, 1);
     state->set_map(state->current_map_index);
 };
 
 auto State::previous_map() -> void
 {
     auto state = State::get_instance();
-
-    state->current_map_index--;
-
-    while (true) {
-        auto desc = map_list[state->current_map_index];
-        if (!desc.valid) {
-            state->current_map_index--;
-            if (state->current_map_index < 0) {
-                state->current_map_index = map_list.size() - 1;
-            }
-            continue;
-        }
-        break;
-    }
-
+    state->current_map_index = step_map(state->current_map_index, -1);
     state->set_map(state->current_map_index);
 };
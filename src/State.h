@@ -2,17 +2,31 @@
 
 #include <array>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <vector>
 
+#include "BVH.h"
 #include "Camera.h"
 #include "FFT.h"
 #include "GUI.h"
+#include "MapCache.h"
+#include "MapLoader.h"
+#include "MapPrefetcher.h"
+#include "Pathfinder.h"
 #include "Renderer.h"
 #include "Scenario.h"
 #include "Scene.h"
 
 #include "sokol_gfx.h"
 
+// PickResult is the map triangle under the cursor.
+struct PickResult {
+    uint32_t triangle = 0;
+    uint16_t polygon = 0;
+    glm::vec3 position = {}; // World space
+};
+
 class State {
 public:
     State(const State&) = delete;
@@ -27,13 +41,28 @@ public:
     }
 
     auto set_scenario(const Scenario scenario) -> void;
-    auto set_map(int map_num, MapTime time = MapTime::Day, MapWeather weather = MapWeather::None, int arrangement = 0) -> bool;
+    // set_map shows a cached map right away, otherwise it starts loading the
+    // map in the background and the current map keeps rendering until
+    // update_map() swaps the new one in.
+    auto set_map(int map_num, MapTime time = MapTime::Day, MapWeather weather = MapWeather::None, int arrangement = 0) -> void;
+
+    // update_map uploads a finished map to the GPU and swaps it into the
+    // scene. It must be called on the main thread, once per frame.
+    auto update_map() -> void;
     auto next_scenario() -> void;
     auto previous_scenario() -> void;
     auto next_map() -> void;
     auto previous_map() -> void;
 
+    // pick casts a ray from the cursor through the orbital camera into the
+    // current map and stores the triangle in `picked` and the terrain tile
+    // in `picked_tile`.
+    auto pick(float mouse_x, float mouse_y) -> void;
+
     Renderer renderer = {};
+    MapPrefetcher map_prefetcher;
+    MapLoader map_loader { &map_prefetcher };
+    MapCache map_cache;
     GUI gui = {};
     Scene scene = {};
     OrbitalCamera orbital_camera = {};
@@ -51,7 +80,31 @@ public:
     int current_map_index = 49;
     int current_style_index = 0;
 
+    // The map on screen, which can lag behind current_map_index while the
+    // next one loads.
+    MapKey current_map_key = { -1 };
+
+    // The current map's triangles and their BVH, for picking.
+    std::shared_ptr<FFTMesh> current_map_mesh = nullptr;
+    std::shared_ptr<Model> current_map_model = nullptr;
+    std::shared_ptr<BVH> current_map_bvh = nullptr;
+    std::optional<PickResult> picked = std::nullopt;
+    std::optional<TileHit> picked_tile = std::nullopt;
+
+    // Movement range of a unit standing on the picked tile.
+    std::shared_ptr<Pathfinder> current_map_pathfinder = nullptr;
+    MoveRules move_rules = {};
+    size_t reachable_tiles = 0;
+    double pick_microseconds = 0.0;
+
 private:
     State() {};
+    auto show_map(const GPUMap& gpu_map) -> void;
+    auto prefetch_neighbours() -> void;
+    auto dispatch_pending_event() -> void;
+
+    // The map current_event waits for before it is dispatched.
+    std::optional<MapKey> pending_event_map = std::nullopt;
+
     static State* instance;
 };
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "Terrain.h"
+
+auto TerrainTile::top() const -> float
+{
+    return (height + slope_height * 0.5f) * TERRAIN_HEIGHT_STEP;
+}
+
+auto TerrainTile::is_empty() const -> bool
+{
+    return surface_type == 0 && height == 0 && slope_height == 0 && slope_type == 0 && depth == 0 && flags == 0;
+}
+
+Terrain::Terrain(std::span<const uint8_t> data)
+{
+    assert(data.size() >= (size_t)TERRAIN_NUM_BYTES);
+
+    size_x = data[0];
+    size_z = data[1];
+    assert(size_x * size_z <= TERRAIN_MAX_TILES);
+
+    // Each level is a full block of TERRAIN_MAX_TILES, rows of size_x tiles.
+    for (int i = 0; i < TERRAIN_LEVELS * TERRAIN_MAX_TILES; i++) {
+        const uint8_t* bytes = &data[2 + i * TERRAIN_TILE_NUM_BYTES];
+        auto& tile = tiles[i];
+        tile.surface_type = bytes[0] & 0x3F;
+        tile.height = bytes[2];
+        tile.slope_height = bytes[3] & 0x1F;
+        tile.depth = bytes[3] >> 5;
+        tile.slope_type = bytes[4];
+        tile.flags = bytes[6];
+    }
+}
+
+auto Terrain::tile(int x, int z, int level) const -> const TerrainTile*
+{
+    if (x < 0 || z < 0 || x >= size_x || z >= size_z || level < 0 || level >= TERRAIN_LEVELS) {
+        return nullptr;
+    }
+    return &tiles[(level * TERRAIN_MAX_TILES) + (z * size_x) + x];
+}
+
+auto Terrain::tile_at(glm::vec3 position, int level) const -> const TerrainTile*
+{
+    int x = (int)std::floor(position.x / TERRAIN_TILE_SIZE);
+    int z = (int)std::floor(-position.z / TERRAIN_TILE_SIZE);
+    return tile(x, z, level);
+}
+
+auto Terrain::intersect(const Ray& ray) const -> std::optional<TileHit>
+{
+    constexpr float INF = std::numeric_limits<float>::infinity();
+    if (!is_valid()) {
+        return std::nullopt;
+    }
+
+    // Work in tile units, with z flipped so tile coordinates grow along
+    // both axes.
+    float u = ray.origin.x / TERRAIN_TILE_SIZE;
+    float w = -ray.origin.z / TERRAIN_TILE_SIZE;
+    float du = ray.direction.x / TERRAIN_TILE_SIZE;
+    float dw = -ray.direction.z / TERRAIN_TILE_SIZE;
+
+    // Clip the ray to the grid.
+    float t_enter = 0.0f;
+    float t_exit = INF;
+    auto clip = [&](float origin, float direction, float size) {
+        if (direction == 0.0f) {
+            return origin >= 0.0f && origin <= size;
+        }
+        float t0 = (0.0f - origin) / direction;
+        float t1 = (size - origin) / direction;
+        t_enter = std::max(t_enter, std::min(t0, t1));
+        t_exit = std::min(t_exit, std::max(t0, t1));
+        return t_enter <= t_exit;
+    };
+    if (!clip(u, du, size_x) || !clip(w, dw, size_z)) {
+        return std::nullopt;
+    }
+
+    int x = std::clamp((int)std::floor(u + du * t_enter), 0, size_x - 1);
+    int z = std::clamp((int)std::floor(w + dw * t_enter), 0, size_z - 1);
+    int step_x = du > 0.0f ? 1 : -1;
+    int step_z = dw > 0.0f ? 1 : -1;
+    float t_next_x = du != 0.0f ? ((x + (du > 0.0f ? 1 : 0)) - u) / du : INF;
+    float t_next_z = dw != 0.0f ? ((z + (dw > 0.0f ? 1 : 0)) - w) / dw : INF;
+    float t_delta_x = du != 0.0f ? std::abs(1.0f / du) : INF;
+    float t_delta_z = dw != 0.0f ? std::abs(1.0f / dw) : INF;
+
+    auto height_at = [&](float t) { return ray.origin.y + ray.direction.y * t; };
+    auto plane_distance = [&](float top) { return (top - ray.origin.y) / ray.direction.y; };
+
+    float t0 = t_enter;
+    while (t0 <= t_exit) {
+        float t1 = std::min({ t_next_x, t_next_z, t_exit });
+        float y0 = height_at(t0);
+        float y1 = height_at(t1);
+
+        std::optional<TileHit> hit = std::nullopt;
+        const auto* lower = tile(x, z, 0);
+        float top = lower->top();
+        if (y0 <= top) {
+            hit = TileHit { x, z, 0, t0 };
+        } else if (y1 <= top) {
+            hit = TileHit { x, z, 0, plane_distance(top) };
+        }
+
+        const auto* upper = tile(x, z, 1);
+        if (!upper->is_empty() && ray.direction.y != 0.0f) {
+            top = upper->top();
+            float t = plane_distance(top);
+            if ((y0 - top) * (y1 - top) <= 0.0f && (!hit.has_value() || t < hit->distance)) {
+                hit = TileHit { x, z, 1, t };
+            }
+        }
+
+        if (hit.has_value()) {
+            return hit;
+        }
+
+        if (t_next_x < t_next_z) {
+            x += step_x;
+            t0 = t_next_x;
+            t_next_x += t_delta_x;
+        } else {
+            z += step_z;
+            t0 = t_next_z;
+            t_next_z += t_delta_z;
+        }
+        if (x < 0 || z < 0 || x >= size_x || z >= size_z) {
+            break;
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "Geometry.h"
+
+#include "glm/glm.hpp"
+
+constexpr int TERRAIN_LEVELS = 2;
+constexpr int TERRAIN_MAX_TILES = 256; // Per level, size_x * size_z
+constexpr int TERRAIN_TILE_NUM_BYTES = 8;
+constexpr int TERRAIN_NUM_BYTES = 2 + (TERRAIN_LEVELS * TERRAIN_MAX_TILES * TERRAIN_TILE_NUM_BYTES);
+
+// Tiles with this flag can't be walked on.
+constexpr uint8_t TERRAIN_FLAG_UNWALKABLE = 0x02;
+
+// Model units per tile on x and z, and per unit of tile height.
+constexpr float TERRAIN_TILE_SIZE = 28.0f;
+constexpr float TERRAIN_HEIGHT_STEP = 12.0f;
+
+// TerrainTile is one tile of the movement grid. On disc it is 8 bytes:
+//
+// - 0: surface type (low 6 bits)
+// - 2: height
+// - 3: slope height (low 5 bits), depth (high 3 bits)
+// - 4: slope type
+// - 6: flags
+//
+// Bytes 1, 5 and 7 are not decoded.
+struct TerrainTile {
+    uint8_t surface_type = 0;
+    uint8_t height = 0;       // Height of the lowest point of the tile
+    uint8_t slope_height = 0; // From the lowest to the highest point
+    uint8_t slope_type = 0;
+    uint8_t depth = 0;        // Water depth
+    uint8_t flags = 0;        // Raw walkability and cursor flags
+    uint8_t padding[2] = {};
+
+    // top returns the model space height of the middle of the tile. Slopes
+    // are treated as flat at half their height.
+    auto top() const -> float;
+    auto is_empty() const -> bool;
+};
+static_assert(sizeof(TerrainTile) == 8);
+
+struct TileHit {
+    int x = 0;
+    int z = 0;
+    int level = 0;
+    float distance = 0.0f; // Along the ray, in units of its direction
+};
+
+// Terrain is the tile grid of a map, with both levels stored densely so a
+// lookup is a single index. The upper level holds things like bridges and
+// is empty on most maps.
+//
+// Tile (x, z) covers model x from x * TERRAIN_TILE_SIZE and model z from
+// -z * TERRAIN_TILE_SIZE, since meshes are flipped on z.
+struct Terrain {
+    uint8_t size_x = 0;
+    uint8_t size_z = 0;
+    std::array<TerrainTile, TERRAIN_LEVELS * TERRAIN_MAX_TILES> tiles = {};
+
+    Terrain() = default;
+    explicit Terrain(std::span<const uint8_t> data);
+
+    auto is_valid() const -> bool { return size_x > 0 && size_z > 0; }
+
+    // tile returns nullptr outside the grid.
+    auto tile(int x, int z, int level = 0) const -> const TerrainTile*;
+    auto tile_at(glm::vec3 position, int level = 0) const -> const TerrainTile*;
+
+    // intersect walks the ray across the grid (Amanatides and Woo) and
+    // returns the first tile it hits. Lower level tiles are solid columns.
+    // Upper level tiles are only hit on their top surface.
+    auto intersect(const Ray& ray) const -> std::optional<TileHit>;
+};
@@ -1,3 +1,4 @@
+#include <cassert>
 #include <iostream>
 #include <stdexcept>
 
@@ -34,32 +35,21 @@ Texture::Texture(std::string filename)
     }
 }
 
-// This is for FFT map textures
-Texture::Texture(std::array<uint8_t, FFT_TEXTURE_NUM_BYTES> data)
+// This is for FFT map textures and palettes. Map textures are R8 palette
+// indices, palettes are RGBA8.
+Texture::Texture(const uint8_t* pixels, int width, int height, sg_pixel_format format)
 {
-    auto resources = ResourceManager::get_instance();
-    sampler = resources->get_sampler("default");
-
-    sg_image_desc image_desc = {};
-    image_desc.width = FFT_TEXTURE_WIDTH;
-    image_desc.height = FFT_TEXTURE_HEIGHT;
-    image_desc.pixel_format = SG_PIXELFORMAT_RGBA8;
-    image_desc.data.subimage[0][0] = { data.data(), static_cast<size_t>(FFT_TEXTURE_WIDTH * FFT_TEXTURE_HEIGHT * 4) };
-
-    image = sg_make_image(&image_desc);
-}
+    assert(format == SG_PIXELFORMAT_RGBA8 || format == SG_PIXELFORMAT_R8);
+    int bytes_per_pixel = format == SG_PIXELFORMAT_R8 ? 1 : 4;
 
-// This is for FFT Palettes
-Texture::Texture(std::array<uint8_t, FFT_PALETTE_NUM_BYTES> data)
-{
     auto resources = ResourceManager::get_instance();
     sampler = resources->get_sampler("default");
 
     sg_image_desc image_desc = {};
-    image_desc.width = FFT_PALETTE_NUM_PIXELS;
-    image_desc.height = 1;
-    image_desc.pixel_format = SG_PIXELFORMAT_RGBA8;
-    image_desc.data.subimage[0][0] = { data.data(), static_cast<size_t>(FFT_PALETTE_NUM_BYTES) };
+    image_desc.width = width;
+    image_desc.height = height;
+    image_desc.pixel_format = format;
+    image_desc.data.subimage[0][0] = { pixels, static_cast<size_t>(width * height * bytes_per_pixel) };
 
     image = sg_make_image(&image_desc);
 }
@@ -7,17 +7,6 @@
 #include "sokol_gfx.h"
 #include "stb_image.h"
 
-// FFT Texture dimensions are always 256 * 256 * 4 pages (256*1024).
-constexpr int FFT_TEXTURE_WIDTH = 256;
-constexpr int FFT_TEXTURE_HEIGHT = 1024;
-constexpr int FFT_TEXTURE_NUM_PIXELS = (256 * 1024);                // 262144
-constexpr int FFT_TEXTURE_NUM_BYTES = (FFT_TEXTURE_NUM_PIXELS * 4); // Pixel * 4 bytes per pixel (RGBA8).
-constexpr int FFT_TEXTURE_RAW_SIZE = (FFT_TEXTURE_NUM_PIXELS / 2);  // Each pixel on disk 1/2 a byte.
-
-// FFT Palette dimensions are always 256 * 1.
-constexpr int FFT_PALETTE_NUM_PIXELS = (16 * 16);
-constexpr int FFT_PALETTE_NUM_BYTES = (FFT_PALETTE_NUM_PIXELS * 4);
-
 struct Sampler {
     Sampler();
     ~Sampler();
@@ -27,8 +16,7 @@ struct Sampler {
 
 struct Texture {
     Texture(std::string filename);
-    Texture(std::array<uint8_t, FFT_TEXTURE_NUM_BYTES> data);
-    Texture(std::array<uint8_t, FFT_PALETTE_NUM_BYTES> data);
+    Texture(const uint8_t* pixels, int width, int height, sg_pixel_format format = SG_PIXELFORMAT_RGBA8);
     ~Texture();
 
     sg_image load_png(const char* filename);
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "VertexCache.h"
+
+// Forsyth's scoring parameters.
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+constexpr int FORSYTH_CACHE_SIZE = 32;
+constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+auto acmr(const std::vector<uint16_t>& indices, size_t num_vertices, size_t cache_size) -> float
+{
+    if (indices.size() < 3) {
+        return 0.0f;
+    }
+
+    // Each vertex remembers the miss count when it entered the cache. It is
+    // still cached while fewer than cache_size misses have happened since.
+    std::vector<size_t> entered(num_vertices, std::numeric_limits<size_t>::max());
+    size_t misses = 0;
+    for (uint16_t index : indices) {
+        if (entered[index] == std::numeric_limits<size_t>::max() || misses - entered[index] >= cache_size) {
+            entered[index] = misses;
+            misses++;
+        }
+    }
+    return (float)misses / (float)(indices.size() / 3);
+}
+
+static auto vertex_score(int cache_position, int remaining_triangles) -> float
+{
+    if (remaining_triangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            // The last triangle's vertices get a fixed score, so the next
+            // triangle doesn't just reuse the same edge.
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        } else {
+            float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cache_position - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    // Vertices with few triangles left are finished off first.
+    score += FORSYTH_VALENCE_BOOST_SCALE * std::pow((float)remaining_triangles, -FORSYTH_VALENCE_BOOST_POWER);
+    return score;
+}
+
+auto optimize_vertex_cache(std::vector<uint16_t>& indices, size_t num_vertices, std::vector<uint32_t>* triangle_order) -> void
+{
+    size_t num_triangles = indices.size() / 3;
+    if (num_triangles == 0) {
+        return;
+    }
+
+    // Triangles using each vertex, as offsets into one flat list.
+    std::vector<uint32_t> offsets(num_vertices + 1, 0);
+    for (uint16_t index : indices) {
+        offsets[index + 1]++;
+    }
+    for (size_t i = 0; i < num_vertices; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<int> remaining(num_vertices);
+    std::vector<int> cache_position(num_vertices, -1);
+    std::vector<float> score(num_vertices);
+    for (size_t v = 0; v < num_vertices; v++) {
+        remaining[v] = offsets[v + 1] - offsets[v];
+        score[v] = vertex_score(-1, remaining[v]);
+    }
+
+    std::vector<float> triangle_score(num_triangles);
+    std::vector<bool> emitted(num_triangles, false);
+    for (size_t t = 0; t < num_triangles; t++) {
+        triangle_score[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint16_t> output;
+    output.reserve(indices.size());
+    std::vector<uint32_t> order;
+    order.reserve(num_triangles);
+
+    // The cache holds FORSYTH_CACHE_SIZE vertices plus room for the three
+    // being pushed in.
+    std::vector<uint16_t> cache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    std::vector<uint16_t> next_cache;
+    next_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t scan_cursor = 0;
+    int64_t best = -1;
+    while (order.size() < num_triangles) {
+        // Nothing in the cache is connected to a remaining triangle, so fall
+        // back to the best scoring triangle. Scores are mostly uniform
+        // there, so the first remaining triangle is close enough.
+        if (best < 0) {
+            while (emitted[scan_cursor]) {
+                scan_cursor++;
+            }
+            best = scan_cursor;
+        }
+
+        emitted[best] = true;
+        order.push_back(best);
+
+        // Move the triangle's vertices to the front of the cache.
+        next_cache.clear();
+        for (int i = 0; i < 3; i++) {
+            uint16_t v = indices[best * 3 + i];
+            output.push_back(v);
+            if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end()) {
+                next_cache.push_back(v);
+            }
+
+            // Remove the triangle from the vertex's remaining list.
+            auto begin = adjacency.begin() + offsets[v];
+            auto end = begin + remaining[v];
+            auto it = std::find(begin, end, (uint32_t)best);
+            if (it != end) {
+                std::iter_swap(it, end - 1);
+                remaining[v]--;
+            }
+        }
+        for (uint16_t v : cache) {
+            if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end()) {
+                next_cache.push_back(v);
+            }
+        }
+        std::swap(cache, next_cache);
+
+        // Vertices that fell off the end are no longer cached.
+        for (size_t i = FORSYTH_CACHE_SIZE; i < cache.size(); i++) {
+            cache_position[cache[i]] = -1;
+            score[cache[i]] = vertex_score(-1, remaining[cache[i]]);
+        }
+        if (cache.size() > (size_t)FORSYTH_CACHE_SIZE) {
+            cache.resize(FORSYTH_CACHE_SIZE);
+        }
+
+        for (size_t i = 0; i < cache.size(); i++) {
+            cache_position[cache[i]] = i;
+            score[cache[i]] = vertex_score(i, remaining[cache[i]]);
+        }
+
+        // Rescore the remaining triangles of cached vertices and pick the
+        // best of them next.
+        best = -1;
+        float best_score = -1.0f;
+        for (uint16_t v : cache) {
+            for (int i = 0; i < remaining[v]; i++) {
+                uint32_t t = adjacency[offsets[v] + i];
+                float s = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                triangle_score[t] = s;
+                if (s > best_score) {
+                    best_score = s;
+                    best = t;
+                }
+            }
+        }
+    }
+
+    indices = std::move(output);
+    if (triangle_order != nullptr) {
+        *triangle_order = std::move(order);
+    }
+}
+
+auto optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<uint16_t>& indices) -> void
+{
+    constexpr uint16_t UNUSED = std::numeric_limits<uint16_t>::max();
+
+    std::vector<uint16_t> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+    for (uint16_t& index : indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = reordered.size();
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices = std::move(reordered);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Geometry.h"
+
+// Post-transform vertex cache optimization for indexed triangle lists.
+
+// VERTEX_CACHE_SIZE is the FIFO size used to measure ACMR. It is a
+// conservative stand-in for the post-transform cache of current GPUs.
+constexpr size_t VERTEX_CACHE_SIZE = 16;
+
+// acmr returns the average cache miss ratio, the number of vertex shader
+// invocations per triangle, of drawing `indices` through a FIFO cache of
+// `cache_size` entries. Lower is better: 3.0 is no reuse at all and a
+// regular grid approaches 0.5.
+auto acmr(const std::vector<uint16_t>& indices, size_t num_vertices, size_t cache_size = VERTEX_CACHE_SIZE) -> float;
+
+// optimize_vertex_cache reorders triangles for cache reuse using Tom
+// Forsyth's linear-speed algorithm. `triangle_order`, if given, receives
+// the source triangle of each output triangle.
+auto optimize_vertex_cache(std::vector<uint16_t>& indices, size_t num_vertices, std::vector<uint32_t>* triangle_order = nullptr) -> void;
+
+// optimize_vertex_fetch reorders vertices into the order the indices first
+// use them, so vertex fetches walk memory linearly. Unused vertices are
+// dropped.
+auto optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<uint16_t>& indices) -> void;
@@ -1,13 +1,22 @@
 #include <array>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "Camera.h"
+#include "CookedCache.h"
 #include "Dispatcher.h"
 #include "FFT.h"
 #include "Model.h"
+#include "Pathfinder.h"
 #include "Pipeline.h"
 #include "ResourceManager.h"
+#include "SIMD.h"
 #include "Shader.h"
 #include "State.h"
 #include "Texture.h"
@@ -29,19 +38,230 @@
 #include "imgui.h"
 #include "sokol_imgui.h"
 
+const std::string FFT_BIN_PATH = "/Users/adam/sync/emu/fft.bin";
+
 bool mouse_left = false;
 bool mouse_right = false;
 
+// bench_paths times pathfinding on the default style of every map: the
+// movement range from every walkable tile and A* between random pairs.
+auto bench_paths(const BinReader& reader) -> void
+{
+    constexpr int NUM_PAIRS = 1000;
+    const MoveRules rules = {};
+
+    std::mt19937 rng(0);
+    double total_reachable_us = 0.0;
+    double total_path_us = 0.0;
+    size_t total_reachable = 0;
+    size_t total_paths = 0;
+
+    for (const auto& [map_num, desc] : map_list) {
+        if (!desc.valid) {
+            continue;
+        }
+        auto map = reader.read_map(map_num, MapTime::Day, MapWeather::None, 0);
+        if (map == nullptr || !map->mesh->terrain.is_valid()) {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Pathfinder pathfinder(map->mesh->terrain);
+        auto build_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<TileId> walkable;
+        for (int tile = 0; tile < PATHFINDER_MAX_TILES; tile++) {
+            if (pathfinder.is_walkable(tile)) {
+                walkable.push_back(tile);
+            }
+        }
+        if (walkable.empty()) {
+            continue;
+        }
+
+        start = std::chrono::steady_clock::now();
+        size_t reached = 0;
+        for (TileId tile : walkable) {
+            reached += pathfinder.reachable(tile, rules).size();
+        }
+        auto reachable_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        std::uniform_int_distribution<size_t> pick(0, walkable.size() - 1);
+        start = std::chrono::steady_clock::now();
+        int found = 0;
+        for (int i = 0; i < NUM_PAIRS; i++) {
+            found += !pathfinder.find_path(walkable[pick(rng)], walkable[pick(rng)], rules).empty();
+        }
+        auto path_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Map " << map_num << ": " << walkable.size() << " tiles, build " << build_us << "us"
+                  << ", reachable " << reachable_us / walkable.size() << "us (" << (double)reached / walkable.size() << " tiles)"
+                  << ", path " << path_us / NUM_PAIRS << "us (" << found << "/" << NUM_PAIRS << " found)" << std::endl;
+
+        total_reachable_us += reachable_us;
+        total_path_us += path_us;
+        total_reachable += walkable.size();
+        total_paths += NUM_PAIRS;
+    }
+
+    std::cout << "Average reachable " << total_reachable_us / std::max(total_reachable, (size_t)1) << "us"
+              << ", path " << total_path_us / std::max(total_paths, (size_t)1) << "us" << std::endl;
+}
+
+// bench_meshes decodes every mesh on the disc with both MeshFile decoders,
+// checks that they agree bit for bit and times them. It returns false on any
+// mismatch.
+auto bench_meshes(const BinReader& reader) -> bool
+{
+    constexpr int NUM_RUNS = 20;
+
+    size_t num_meshes = 0;
+    size_t num_corners = 0;
+    double total_us = 0.0;
+    double total_reference_us = 0.0;
+    bool ok = true;
+
+    for (const auto& [map_num, records] : reader.read_all_records()) {
+        for (const auto& record : records) {
+            if (record.resource_type != ResourceType::MeshPrimary
+                && record.resource_type != ResourceType::MeshOverride
+                && record.resource_type != ResourceType::MeshAlt) {
+                continue;
+            }
+            auto file = reader.read_mesh_file(record.sector, record.length);
+
+            auto reference = file.read_vertices_reference();
+            auto [vertices, indices, polygons] = file.read_vertices();
+            bool matches = reference.size() == indices.size();
+            for (size_t i = 0; matches && i < indices.size(); i++) {
+                matches = std::memcmp(&reference[i], &vertices[indices[i]], sizeof(Vertex)) == 0;
+            }
+            if (!matches) {
+                std::cout << "Map " << map_num << " " << record.repr() << ": decoders disagree" << std::endl;
+                ok = false;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < NUM_RUNS; i++) {
+                file.read_vertices();
+            }
+            total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / NUM_RUNS;
+
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < NUM_RUNS; i++) {
+                file.read_vertices_reference();
+            }
+            total_reference_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / NUM_RUNS;
+
+            num_meshes++;
+            num_corners += reference.size();
+        }
+    }
+
+    std::cout << "Decoded " << num_meshes << " meshes (" << num_corners << " triangle corners)"
+              << ": read_vertices " << total_us / 1000.0 << "ms, reference " << total_reference_us / 1000.0 << "ms"
+              << " (" << simd_path() << ")" << (ok ? "" : ", MISMATCHES FOUND") << std::endl;
+    return ok;
+}
+
+// bench_simd checks every SIMD path against the scalar kernels, bit for bit,
+// on sizes around each path's block widths, then times them on a map's worth
+// of data. It returns false on any mismatch.
+auto bench_simd() -> bool
+{
+    constexpr int NUM_RUNS = 500;
+    const auto& paths = simd_paths();
+    const auto& scalar = paths.front();
+
+    std::mt19937 rng(0);
+    auto random_bytes = [&](size_t count) {
+        std::vector<uint8_t> bytes(count);
+        for (auto& byte : bytes) {
+            byte = rng();
+        }
+        return bytes;
+    };
+
+    auto same_bits = [](const std::vector<float>& a, const std::vector<float>& b) {
+        return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0);
+    };
+
+    bool ok = true;
+    for (const auto& path : paths) {
+        for (size_t count : { 0, 1, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 1000, FFT_TEXTURE_RAW_SIZE }) {
+            auto in = random_bytes(count * 2);
+
+            std::vector<uint8_t> expected_indices(count * 2), indices(count * 2);
+            scalar.unpack_4bpp(in.data(), count, expected_indices.data());
+            path.unpack_4bpp(in.data(), count, indices.data());
+
+            std::vector<float> expected_floats(count), floats(count);
+            scalar.convert_i16(in.data(), count, 1.0f / 4096.0f, expected_floats.data());
+            path.convert_i16(in.data(), count, 1.0f / 4096.0f, floats.data());
+
+            // Positions are read out of Vertex arrays, so use its stride.
+            size_t stride = sizeof(Vertex) / sizeof(float);
+            size_t num_points = count / stride;
+            std::vector<float> points(num_points * stride);
+            for (size_t i = 0; i < points.size(); i++) {
+                points[i] = floats[i] * 1000.0f;
+            }
+            float expected_min[3] = { 1e30f, 1e30f, 1e30f }, expected_max[3] = { -1e30f, -1e30f, -1e30f };
+            float min[3] = { 1e30f, 1e30f, 1e30f }, max[3] = { -1e30f, -1e30f, -1e30f };
+            scalar.minmax_xyz(points.data(), num_points, stride, expected_min, expected_max);
+            path.minmax_xyz(points.data(), num_points, stride, min, max);
+
+            bool matches = indices == expected_indices
+                && same_bits(floats, expected_floats)
+                && std::memcmp(min, expected_min, sizeof(min)) == 0
+                && std::memcmp(max, expected_max, sizeof(max)) == 0;
+            if (!matches) {
+                std::cout << path.name << ": mismatch with scalar at " << count << " elements" << std::endl;
+                ok = false;
+            }
+        }
+    }
+
+    // One map texture, and the positions and normals of a large mesh.
+    auto texture = random_bytes(FFT_TEXTURE_RAW_SIZE);
+    std::vector<uint8_t> indices(FFT_TEXTURE_NUM_BYTES);
+    auto mesh = random_bytes(6 * 3 * 4096);
+    std::vector<float> floats(mesh.size() / 2);
+    for (const auto& path : paths) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_RUNS; i++) {
+            path.unpack_4bpp(texture.data(), texture.size(), indices.data());
+        }
+        auto unpack_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / NUM_RUNS;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_RUNS; i++) {
+            path.convert_i16(mesh.data(), floats.size(), 1.0f, floats.data());
+        }
+        auto convert_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / NUM_RUNS;
+
+        std::cout << path.name << ": unpack_4bpp " << unpack_us << "us per texture, convert_i16 " << convert_us << "us per " << floats.size() << " values" << std::endl;
+    }
+
+    std::cout << "Selected path: " << simd_path() << (ok ? "" : ", MISMATCHES FOUND") << std::endl;
+    return ok;
+}
+
 auto init() -> void
 {
     auto state = State::get_instance();
     auto resources = ResourceManager::get_instance();
-    auto reader = std::make_shared<BinReader>("/Users/adam/sync/emu/fft.bin");
+
+    auto reader = std::make_shared<BinReader>(FFT_BIN_PATH);
     resources->set_bin_reader(reader);
+    resources->set_cooked_cache(std::make_shared<CookedCache>(FFT_BIN_PATH + ".cooked", reader->fingerprint()));
 
     // Parse global data
+    auto start = std::chrono::steady_clock::now();
     state->scenarios = reader->read_scenarios();
     state->events = reader->read_events();
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    std::cout << "Read " << state->scenarios.size() << " scenarios and " << state->events.size() << " events in " << elapsed.count() << "ms" << std::endl;
 
     // Setup scenario to render
     state->set_scenario(state->scenarios[52]);
@@ -108,6 +328,8 @@ auto input(sapp_event const* event) -> void
             if (mouse_right) {
                 state->orbital_camera.pan(event->mouse_dx * 0.0025f, event->mouse_dy * 0.0025f);
             }
+        } else {
+            state->pick(event->mouse_x, event->mouse_y);
         }
         break;
     default:
@@ -123,6 +345,7 @@ auto frame() -> void
     auto dispatcher = Dispatcher::get_instance();
 
     // Update
+    state->update_map();
     dispatcher->update();
     state->orbital_camera.update();
     state->fps_camera.update();
@@ -137,8 +360,34 @@ auto frame() -> void
 
 sapp_desc sokol_main(int argc, char* argv[])
 {
-    (void)argc;
-    (void)argv;
+    // --cook decodes every map style into the cooked cache and exits
+    // without opening a window.
+    if (argc > 1 && std::string(argv[1]) == "--cook") {
+        BinReader reader(FFT_BIN_PATH);
+        CookedCache cache(FFT_BIN_PATH + ".cooked", reader.fingerprint());
+        cache.cook_all(reader, std::thread::hardware_concurrency());
+        exit(0);
+    }
+
+    // --bench-paths runs the pathfinding benchmark over every map and exits.
+    if (argc > 1 && std::string(argv[1]) == "--bench-paths") {
+        BinReader reader(FFT_BIN_PATH);
+        bench_paths(reader);
+        exit(0);
+    }
+
+    // --bench-meshes checks and times the mesh decoder on every disc mesh.
+    if (argc > 1 && std::string(argv[1]) == "--bench-meshes") {
+        BinReader reader(FFT_BIN_PATH);
+        exit(bench_meshes(reader) ? 0 : 1);
+    }
+
+    // --bench-simd checks the SIMD kernels against scalar and times them. It
+    // needs no disc image.
+    if (argc > 1 && std::string(argv[1]) == "--bench-simd") {
+        exit(bench_simd() ? 0 : 1);
+    }
+
     sapp_desc desc = {};
     desc.init_cb = init;
     desc.frame_cb = frame;
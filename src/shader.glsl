@@ -32,6 +32,41 @@ void main() {
 }
 @end
 
+// vs_map decodes the packed MapVertex layout of map meshes. See Mesh.h.
+@vs vs_map
+uniform vs_map_params{
+    mat4 u_view_proj;
+    mat4 u_model;
+};
+
+in vec4 a_position; // x, y, z, unused
+in vec4 a_normal;   // xyz mapped to 0-1, w is 1.0 for textured vertices, else 0.0
+in vec4 a_uv;       // u, v, page, palette
+
+out vec4 v_position;
+out vec3 v_normal;
+out vec2 v_uv;
+out float v_palette_index;
+
+void main() {
+    v_position = u_model * vec4(a_position.xyz, 1.0);
+
+    // Untextured vertices have no normal or uv, which fs_paletted draws black.
+    v_normal = vec3(0.0, 0.0, 0.0);
+    v_uv = vec2(0.0, 0.0);
+    if (a_normal.w > 0.5) {
+        vec3 normal = mat3(transpose(inverse(u_model))) * (a_normal.xyz * 2.0 - 1.0);
+        if (length(normal) > 0.0) {
+            v_normal = normalize(normal);
+        }
+        v_uv = vec2(a_uv.x / 255.0, (a_uv.y + a_uv.z * 256.0) / 1023.0);
+    }
+
+    v_palette_index = a_uv.w;
+    gl_Position = u_view_proj * v_position;
+}
+@end
+
 @vs vs_background
 in vec3 a_position;
 
@@ -142,6 +177,7 @@ void main() {
         // And palette_pos needs to be calculated then cast to uint,
         // not casting each to uint then calculating. Otherwise there
         // will be distortion in perspective projection on some gpus.
+        // The map texture is R8, one palette index per texel.
         vec4 tex_color = texture(sampler2D(tex, smp), v_uv) * 255.0;
         uint palette_pos = uint(v_palette_index * 16 + tex_color.r);
         vec4 color = texture(sampler2D(palette, smp), vec2(float(palette_pos) / 255.0, 0.0));
@@ -196,6 +232,6 @@ void main() {
 @end
 
 @program textured   vs_standard   fs_textured
-@program paletted   vs_standard   fs_paletted
+@program paletted   vs_map        fs_paletted
 @program colored    vs_standard   fs_colored
 @program background vs_background fs_background